@@ -0,0 +1,105 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#ifndef EXEC_PLAN_H
+#define EXEC_PLAN_H
+
+#include <vector>
+
+#include "opencl_include.hpp"
+#include "ocl_dev_mgr.hpp"
+
+
+// Flat list of pre-resolved kernel launches. The plan is built once after the
+// kernels have been compiled, such that no string lookups are necessary in the
+// repetition loop.
+class exec_plan {
+public:
+  // kernel argument a dataset is bound to
+  struct arg_target {
+    cl::Kernel* kernel;
+    cl_uint arg_idx;
+  };
+
+  // launches exceeding device or driver limits are split into several parts
+  struct launch_part {
+    cl::NDRange range_start;
+    cl::NDRange global_range;
+  };
+
+  struct launch {
+    cl::Kernel* kernel;
+    cl::CommandQueue* queue;
+    std::vector<launch_part> parts;
+    cl::NDRange local_range;
+    std::vector<cl_uint> buffers;       // indices of the data buffers accessed by the launch
+    std::vector<cl::Event> wait_events; // transfers the first execution has to wait for
+    size_t first_event;                 // index of the event of the first part within a repetition
+  };
+
+  // add a launch of the 3D ranges, where a local range of zeros is chosen by the OpenCL implementation;
+  // the global range is split into parts of at most `max_range` work-items per dimension
+  void add_launch(cl::Kernel* kernel, cl::CommandQueue* queue,
+                  cl_ulong const* range_start, cl_ulong const* global_range, cl_ulong const* local_range,
+                  cl_ulong max_range, std::vector<cl_uint> const& buffers);
+  size_t size() const { return launches.size(); }
+  launch& at(size_t idx) { return launches.at(idx); }
+
+  // let the first launch accessing buffer `buffer_idx` wait for `event`, e.g. the upload of the buffer
+  void add_buffer_dependency(cl_uint buffer_idx, cl::Event const& event);
+  // get the events a readback of buffer `buffer_idx` has to wait for (only in asynchronous mode,
+  // all kernels have already completed otherwise)
+  void get_buffer_events(cl_uint buffer_idx, std::vector<cl::Event>& events) const;
+
+  // swap the buffers `buffer_a` and `buffer_b` bound to the arguments `targets_a` and `targets_b`
+  // every `swap_interval` repetitions (ping-pong buffers of time-steppers)
+  void add_swap(cl_uint buffer_a_idx, cl::Buffer* buffer_a, std::vector<arg_target> const& targets_a,
+                cl_uint buffer_b_idx, cl::Buffer* buffer_b, std::vector<arg_target> const& targets_b);
+  void set_swap_interval(cl_ulong interval) { swap_interval = interval; }
+  // whether the buffers of swap `swap_idx` are bound to the arguments of the respective other one
+  bool is_swapped(size_t swap_idx) const { return swaps.at(swap_idx).swapped; }
+  cl_ulong get_swap_count() const { return swap_count; }
+
+  // execute all launches `repetitions` times and return the execution time in µs;
+  // in asynchronous mode, the launches are only enqueued and the time is returned by `finish`
+  cl_ulong execute(ocl_dev_mgr& dev_mgr, cl_ulong repetitions, bool async_mode);
+  cl_ulong finish(ocl_dev_mgr& dev_mgr);
+
+  // profiling information of a launch; the timestamps span all parts, the duration is the sum of
+  // the START to END times of the parts
+  struct launch_timing {
+    cl_ulong duration;
+    ocl_dev_mgr::profiling_info profile;
+    cl_uint context_idx;  // set by the executors using several contexts, 0 otherwise
+  };
+
+  // append the timing of the last execution of launch i to `times[i]`, ordered by repetition;
+  // the timings are stored in a preallocated array
+  void append_launch_times(std::vector<std::vector<launch_timing>>& times) const;
+  // time in µs from the START of the first to the END of the last launch of the last execution
+  cl_ulong get_device_span() const;
+
+private:
+  struct swap {
+    cl::Buffer* buffer_a;
+    cl::Buffer* buffer_b;
+    std::vector<arg_target> targets_a;
+    std::vector<arg_target> targets_b;
+    bool swapped;
+  };
+
+  void apply_swaps();
+
+  std::vector<launch> launches;
+  size_t parts_per_repetition = 0;
+  std::vector<swap> swaps;
+  cl_ulong swap_interval = 1;
+  cl_ulong swap_count = 0;
+  std::vector<cl::Event> kernel_events;
+  void add_part_timing(launch_timing& timing, ocl_dev_mgr::profiling_info const& part_profile, bool first_part);
+
+  std::vector<launch_timing> launch_times;  // per repetition and launch
+  cl_ulong timed_repetitions = 0;
+  cl_ulong enqueued_repetitions = 0;
+};
+
+#endif // EXEC_PLAN_H
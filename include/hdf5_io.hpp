@@ -3,6 +3,9 @@
 #ifndef HDF5_IO_H
 #define HDF5_IO_H
 
+#include <string>
+#include <vector>
+
 #include "hdf5.h"
 #include "hdf5_hl.h"
 
@@ -12,17 +15,89 @@
 enum HD5_Type { H5_float, H5_double, H5_char, H5_uchar, H5_short, H5_ushort, H5_int, H5_uint, H5_long, H5_ulong };
 
 
+// RAII session of an HDF5 file. The file is opened once and kept open until the
+// object is destroyed, such that several reads and writes do not have to pay for
+// opening and closing the file again.
+class h5_file {
+public:
+  enum access_mode {
+    read_only,  // open an existing file for reading
+    read_write, // open an existing file or create a new one if it does not exist
+    truncate    // create a new file, deleting an existing one
+  };
+
+  explicit h5_file(char const* filename, access_mode mode = read_only);
+  explicit h5_file(std::string const& filename, access_mode mode = read_only);
+  ~h5_file();
+
+  h5_file(h5_file const&) = delete;
+  h5_file& operator=(h5_file const&) = delete;
+
+  hid_t id() const { return h5_file_id; }
+  bool is_open() const { return h5_file_id >= 0; }
+  char const* name() const { return filename.c_str(); }
+  void flush() const;
+  void close();
+
+private:
+  std::string filename;
+  hid_t h5_file_id;
+};
+
+
+// compression policy used when writing buffers
+struct h5_compression {
+  enum filter_type {
+    none,            // no filter; contiguous layout unless a chunk shape is given
+    deflate,         // gzip with level `level`
+    shuffle_deflate, // byte shuffle followed by gzip with level `level`
+    scaleoffset      // HDF5 scale-offset filter; `level` decimal digits for floating point types
+  };
+
+  filter_type filter = deflate;
+  int level = 9;
+  bool level_given = false;   // `level` set explicitly; required by the lossy scale-offset filter for floating point data
+  std::vector<hsize_t> chunk; // explicit chunk shape; empty: chosen automatically
+  unsigned int threads = 1;   // threads compressing the chunks for (shuffle_)deflate
+};
+
+char const* h5_compression_name(h5_compression::filter_type filter);
+bool h5_parse_compression(std::string const& name, h5_compression::filter_type& filter);
+
+// read the run-wide policy from the datasets `Compression`, `Compression_Level` and
+// `Compression_Chunk` and write it in the same format
+bool h5_read_compression(h5_file const& file, h5_compression& compression);
+bool h5_write_compression(h5_file const& file, h5_compression const& compression);
+
+// read a per-dataset policy from the attributes `compression`, `compression_level` and
+// `chunk` of `varname` (overriding only the given settings) and write it in the same format;
+// the policy is checked against the type of the dataset `varname`: `scaleoffset` on floating point
+// data without an explicit level is rejected
+bool h5_read_compression_attributes(h5_file const& file, char const* varname, h5_compression& compression);
+bool h5_write_compression_attributes(h5_file const& file, char const* varname, h5_compression const& compression);
+
+
+bool h5_check_object(h5_file const& file, char const* varname);
 bool h5_check_object(char const* filename, char const* varname);
 
+// get the dimensions of a dataset
+bool h5_get_dims(h5_file const& file, char const* varname, std::vector<hsize_t>& dims);
+
+bool h5_get_content(h5_file const& file, char const* hdf_dir,
+                    std::vector<std::string>& data_names, std::vector<HD5_Type>& data_types, std::vector<size_t>& data_sizes);
 bool h5_get_content(char const* filename, char const* hdf_dir,
                     std::vector<std::string>& data_names, std::vector<HD5_Type>& data_types, std::vector<size_t>& data_sizes);
 
+bool h5_create_dir(h5_file const& file, char const* hdf_dir);
 bool h5_create_dir(char const* filename, char const* hdf_dir);
 inline bool h5_create_dir(std::string const& filename, char const* hdf_dir)
 {
   return h5_create_dir(filename.c_str(), hdf_dir);
 }
 
+// copy a dataset including its attributes and storage layout from one file to another
+bool h5_copy_object(h5_file const& src_file, h5_file const& dst_file, char const* varname);
+
 
 // convert a C type TYPE to the HDF5 identifier of that type
 template<typename TYPE>
@@ -35,7 +110,14 @@ constexpr size_t get_vector_size();
 
 // read a buffer from an HDF5 file
 template<typename TYPE>
-bool h5_read_buffer(char const* filename, char const* varname, TYPE* data);
+bool h5_read_buffer(h5_file const& file, char const* varname, TYPE* data);
+
+template<typename TYPE>
+inline bool h5_read_buffer(char const* filename, char const* varname, TYPE* data)
+{
+  h5_file file(filename, h5_file::read_only);
+  return h5_read_buffer<TYPE>(file, varname, data);
+}
 
 template<typename TYPE>
 inline bool h5_read_buffer(std::string const& filename, char const* varname, TYPE* data)
@@ -45,7 +127,15 @@ inline bool h5_read_buffer(std::string const& filename, char const* varname, TYP
 
 // write a buffer to an HDF5 file using compression
 template<typename TYPE>
-bool h5_write_buffer(char const* filename, char const* varname, TYPE const* data, size_t size);
+bool h5_write_buffer(h5_file const& file, char const* varname, TYPE const* data, size_t size,
+                     h5_compression const& compression = h5_compression());
+
+template<typename TYPE>
+inline bool h5_write_buffer(char const* filename, char const* varname, TYPE const* data, size_t size)
+{
+  h5_file file(filename, h5_file::read_write);
+  return h5_write_buffer<TYPE>(file, varname, data, size);
+}
 
 template<typename TYPE>
 inline bool h5_write_buffer(std::string const& filename, char const* varname, TYPE const* data, size_t size)
@@ -54,7 +144,32 @@ inline bool h5_write_buffer(std::string const& filename, char const* varname, TY
 }
 
 
+// size in bytes of a single element of the type `type`
+size_t h5_type_size(HD5_Type type);
+
+// read and write buffers whose type is only known at runtime
+bool h5_read_buffer(h5_file const& file, char const* varname, HD5_Type type, void* data);
+bool h5_write_buffer(h5_file const& file, char const* varname, HD5_Type type, void const* data, size_t size,
+                     h5_compression const& compression = h5_compression());
+
+// create a buffer of `size` elements which is written in parts using h5_write_rows
+bool h5_create_buffer(h5_file const& file, char const* varname, HD5_Type type, size_t size,
+                      h5_compression const& compression = h5_compression());
+// read or write the rows [row_offset, row_offset + num_rows) of the slowest varying dimension of a
+// dataset (hyperslab), e.g. to process datasets which do not fit into the memory in tiles
+bool h5_read_rows(h5_file const& file, char const* varname, HD5_Type type, hsize_t row_offset, hsize_t num_rows, void* data);
+bool h5_write_rows(h5_file const& file, char const* varname, HD5_Type type, hsize_t row_offset, hsize_t num_rows, void const* data);
+
+
 // read a single item from an HDF5 file
+template<typename TYPE>
+TYPE h5_read_single(h5_file const& file, char const* varname)
+{
+  TYPE data;
+  h5_read_buffer<TYPE>(file, varname, &data);
+  return data;
+}
+
 template<typename TYPE>
 TYPE h5_read_single(char const* filename, char const* varname)
 {
@@ -71,7 +186,14 @@ inline TYPE h5_read_single(std::string const& filename, char const* varname)
 
 // write a single item to an HDF5 file
 template<typename TYPE>
-bool h5_write_single(char const* filename, char const* varname, TYPE data);
+bool h5_write_single(h5_file const& file, char const* varname, TYPE data);
+
+template<typename TYPE>
+inline bool h5_write_single(char const* filename, char const* varname, TYPE data)
+{
+  h5_file file(filename, h5_file::read_write);
+  return h5_write_single<TYPE>(file, varname, data);
+}
 
 template<typename TYPE>
 inline bool h5_write_single(std::string const& filename, char const* varname, TYPE data)
@@ -81,6 +203,8 @@ inline bool h5_write_single(std::string const& filename, char const* varname, TY
 
 
 // reading and writing single strings
+bool h5_read_string(h5_file const& file, char const* varname, std::string& output);
+bool h5_write_string(h5_file const& file, char const* varname, std::string const& output);
 bool h5_read_string(char const* filename, char const* varname, std::string& output);
 bool h5_write_string(char const* filename, char const* varname, std::string const& output);
 
@@ -93,8 +217,23 @@ inline bool h5_write_string(std::string const& filename, char const* varname, st
   return h5_write_string(filename.c_str(), varname, buffer);
 }
 
+// check for, read and write attributes of the object `objname`
+bool h5_check_attribute(h5_file const& file, char const* objname, char const* attrname);
+size_t h5_get_attribute_size(h5_file const& file, char const* objname, char const* attrname);
+
+template<typename TYPE>
+bool h5_read_attribute(h5_file const& file, char const* objname, char const* attrname, TYPE* data);
+template<typename TYPE>
+bool h5_write_attribute(h5_file const& file, char const* objname, char const* attrname, TYPE const* data, size_t size);
+
+bool h5_read_attribute_string(h5_file const& file, char const* objname, char const* attrname, std::string& output);
+bool h5_write_attribute_string(h5_file const& file, char const* objname, char const* attrname, std::string const& value);
+
+
 // reading and writing arrays of strings using the format of the (deprecated)
 // matlab function hdfwrite for cell arrays of strings (aka char arrays)
+bool h5_read_strings(h5_file const& file, char const* varname, std::vector<std::string>& lines);
+bool h5_write_strings(h5_file const& file, char const* varname, std::vector<std::string> const& lines);
 bool h5_read_strings(char const* filename, char const* varname, std::vector<std::string>& lines);
 bool h5_write_strings(char const* filename, char const* varname, std::vector<std::string> const& lines);
 
@@ -108,4 +247,18 @@ inline bool h5_write_strings(std::string const& filename, char const* varname, s
 }
 
 
+// row of the table of transfers per dataset; times in ms, zero if the step is not performed
+struct h5_transfer_record {
+  std::string name;
+  cl_ulong bytes;
+  double read_time;     // HDF5 read (including decompression)
+  double upload_time;   // host to device
+  double download_time; // device to host
+  double write_time;    // HDF5 write (including compression)
+};
+
+// write the records as table (compound dataset) with the durations and the resulting bandwidths in GB/s
+bool h5_write_transfer_table(h5_file const& file, char const* varname, std::vector<h5_transfer_record> const& records);
+
+
 #endif // HDF5_IO_H
@@ -0,0 +1,99 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#ifndef MULTI_DEVICE_H
+#define MULTI_DEVICE_H
+
+#include <string>
+#include <vector>
+
+#include "opencl_include.hpp"
+#include "ocl_dev_mgr.hpp"
+#include "exec_plan.hpp"
+#include "hdf5_io.hpp"
+#include "timer.hpp"
+
+
+// Execution on several devices, one per context. All bound datasets are replicated on every
+// device and the rows of their slowest varying dimension are partitioned between the devices.
+// The first repetition uses an even split and calibrates the throughput of each device; the
+// partition is adjusted to the measured throughput after every repetition. The rows written by
+// the other devices are exchanged between the repetitions and gathered into the output file,
+// hence the launches of a repetition must not read rows written by another device (a single kernel).
+class multi_device_executor {
+public:
+  struct dataset {
+    std::string name;
+    HD5_Type type;
+    cl_ulong row_size;  // elements per row
+    cl_int rw_flag;     // 0 = read_write, 1 = read_only, 2 = write_only
+    bool output;        // written to the output file
+    h5_compression compression;
+    std::vector<std::vector<exec_plan::arg_target>> targets; // per context
+  };
+
+  struct launch {
+    std::string kernel_name;
+    cl_ulong range_start[3];
+    cl_ulong global_range[3];
+    cl_ulong local_range[3];
+    cl_uint split_dim;          // dimension of the NDRange along the rows
+    std::vector<cl_uint> buffers;
+  };
+
+  // the contexts `0, ..., num_contexts - 1` are used; the partition is a multiple of `row_multiple`
+  multi_device_executor(ocl_dev_mgr& dev_mgr, cl_uint num_contexts, cl_ulong num_rows, cl_ulong row_multiple);
+
+  void add_dataset(dataset const& data) { datasets.push_back(data); }
+  size_t num_datasets() const { return datasets.size(); }
+  void add_launch(launch const& item) { launches.push_back(item); }
+  cl_uint num_devices() const { return num_contexts; }
+
+  // rows processed by each device in the last repetition
+  std::vector<cl_ulong> get_device_rows() const;
+
+  // Pin the host threads uploading the data of context i to the CPUs of NUMA node i, such that
+  // the buffers of CPU sub-devices are first touched on their own node (Linux only). The
+  // sub-devices of an affinity domain partition are assumed to be in the order of the nodes.
+  bool set_numa_affinity();
+
+  // execute all launches `repetitions` times and return the kernel execution time in µs, i.e.
+  // the sum of the slowest device per repetition
+  cl_ulong execute(h5_file const& config_file, h5_file const& out_file, cl_ulong repetitions, cl_ulong max_launch_range);
+
+  // timing of all executions of launch i, ordered by repetition and device
+  std::vector<std::vector<exec_plan::launch_timing>> const& get_launch_times() const { return launch_times; }
+
+  // HDF5 and transfer times of dataset i; the transfers are summed over all devices, including
+  // the exchanges between the repetitions
+  std::vector<h5_transfer_record> const& get_transfer_records() const { return transfer_records; }
+
+private:
+  bool upload(h5_file const& config_file);
+  bool first_touch(cl_uint context_idx);
+  void partition();
+  bool exchange();
+  bool gather(h5_file const& out_file);
+
+  size_t row_bytes(size_t data_idx) const { return datasets.at(data_idx).row_size * h5_type_size(datasets.at(data_idx).type); }
+
+  ocl_dev_mgr& dev_mgr;
+  cl_uint num_contexts;
+  cl_ulong num_rows;
+  cl_ulong row_multiple;
+
+  std::vector<dataset> datasets;
+  std::vector<launch> launches;
+  std::vector<std::vector<cl::Buffer>> buffers;    // per context and dataset
+  std::vector<std::vector<cl::Event>> transfers;   // last transfer per context and dataset
+  std::vector<std::vector<char>> host_data;        // host copy per dataset
+  std::vector<cl_ulong> row_begin;                 // first row per context and `num_rows`
+  std::vector<double> throughput;                  // rows per µs per context, 0 if unknown
+  std::vector<std::vector<int>> host_cpus;         // CPUs of the upload thread per context, if pinned
+  std::vector<std::vector<exec_plan::launch_timing>> launch_times; // timing per launch
+  Timer timer;
+  std::vector<h5_transfer_record> transfer_records; // per dataset
+  std::vector<std::vector<cl::Event>> upload_events;   // per dataset, profiled at the end
+  std::vector<std::vector<cl::Event>> readback_events; // per dataset
+};
+
+#endif // MULTI_DEVICE_H
@@ -23,18 +23,31 @@ public:
     cl::Platform platform;
     cl_device_type type;
     std::string ocl_version;
+    std::string driver_version;
     cl_ulong max_mem;
     cl_ulong max_mem_alloc;
+    cl_ulong local_mem;
     size_t wg_size;
     cl_uint lw_dim;
     size_t lw_size;
     cl_uint compute_units;
+    cl_uint address_bits;
+    cl_bool host_unified;
     cl_uint copy_perf;
     cl_uint double_perf;
     cl_uint float_perf;
   };
 
+  // profiling timestamps of a command in ns
+  struct profiling_info {
+    cl_ulong queued;
+    cl_ulong submit;
+    cl_ulong start;
+    cl_ulong end;
+  };
+
   cl_ulong init_device(cl_uint avail_device_idx);
+  cl_ulong init_sub_devices(cl_uint avail_device_idx);
   cl::CommandQueue& get_queue(cl_uint context_idx, cl_uint queue_idx);
   cl::Context& get_context(cl_uint context_idx);
   cl::Program& get_program(cl_uint context_idx, std::string const& prog_name);
@@ -43,12 +56,23 @@ public:
   ocl_device_info& get_avail_dev_info(cl_uint avail_device_idx);
   ocl_device_info& get_context_dev_info(cl_uint context_idx, cl_uint device_idx);
   cl_ulong compile_kernel(cl_uint context_idx, std::string const& prog_name, std::string const& options);
+  cl_ulong compile_kernel_cached(cl_uint context_idx, std::string const& prog_name, std::string const& options,
+                                 std::string const& cache_dir, bool& cache_hit);
+  std::string get_build_log(cl_uint context_idx, std::string const& prog_name);
   cl_ulong get_kernel_names(cl_uint context_idx, std::string const& prog_name, std::vector<std::string>& found_kernels);
+  cl_uint get_kernel_arg_names(cl::Kernel& kernel, std::vector<std::string>& arg_names);
   cl_ulong execute_kernel(cl::Kernel& kernel, cl::CommandQueue& queue,
                           cl::NDRange global_range, cl::NDRange local_range,
                           std::vector<cl::Buffer*>& dev_Buffers);
   cl_ulong execute_kernelNA(cl::Kernel& kernel, cl::CommandQueue& queue,
-                            cl::NDRange range_start, cl::NDRange global_range, cl::NDRange local_range);
+                            cl::NDRange range_start, cl::NDRange global_range, cl::NDRange local_range,
+                            std::vector<cl::Event> const* wait_events = NULL, profiling_info* profile = NULL);
+  void enqueue_kernelNA(cl::Kernel& kernel, cl::CommandQueue& queue,
+                        cl::NDRange range_start, cl::NDRange global_range, cl::NDRange local_range,
+                        cl::Event* event, std::vector<cl::Event> const* wait_events = NULL);
+  cl_ulong get_profiling_time(std::vector<cl::Event> const& events);
+  cl_ulong get_event_time(cl::Event const& event);
+  bool get_profiling_info(cl::Event const& event, profiling_info& info);
   void execute_kernel_async(cl::Kernel& kernel, cl::CommandQueue& queue,
                             cl::NDRange global_range, cl::NDRange local_range,
                             std::vector<cl::Buffer*>& dev_Buffers);
@@ -70,6 +94,7 @@ private:
     std::vector<cl::CommandQueue> queues;
     std::vector<cl::Program> programs;
     std::vector<std::string> prog_names;
+    std::vector<std::string> prog_sources;
     std::vector<std::vector<cl::Kernel>> kernels;
     std::vector<std::vector<std::string>> kernel_names;
     std::vector<ocl_device_info> devices;
@@ -78,6 +103,8 @@ private:
   void initialize();
   ocl_dev_mgr();
   cl_ulong getDeviceList(std::vector<cl::Device>& devices);
+  cl_ulong add_context(ocl_device_info const& device_info);
+  cl_ulong create_kernels(cl_uint context_idx, size_t prog_idx);
 
   std::vector<ocl_device_info> available_devices;
   cl_ulong num_available_devices;
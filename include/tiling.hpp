@@ -0,0 +1,88 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#ifndef TILING_H
+#define TILING_H
+
+#include <string>
+#include <vector>
+
+#include "opencl_include.hpp"
+#include "ocl_dev_mgr.hpp"
+#include "exec_plan.hpp"
+#include "hdf5_io.hpp"
+#include "timer.hpp"
+
+
+// Out-of-core execution of datasets which do not fit into the device memory. The datasets are
+// split into tiles of rows of their slowest varying dimension, which are streamed through two
+// sets of fixed-size device buffers: while the kernels process one tile, the next tile is read
+// from the HDF5 file and uploaded and the previous one is downloaded and written.
+class tiled_executor {
+public:
+  struct dataset {
+    std::string name;
+    HD5_Type type;
+    cl_ulong row_size;  // elements per row
+    cl_int rw_flag;     // 0 = read_write, 1 = read_only, 2 = write_only
+    bool output;        // written to the output file
+    h5_compression compression;
+    std::vector<exec_plan::arg_target> targets;
+  };
+
+  struct launch {
+    cl::Kernel* kernel;
+    cl_ulong range_start[3];
+    cl_ulong global_range[3];
+    cl_ulong local_range[3];
+    cl_uint tile_dim;           // dimension of the NDRange along the rows
+    cl_int tile_offset_idx;     // index of the argument `tile_offset` or -1
+    std::vector<cl_uint> buffers;
+  };
+
+  // `halo` rows before and after each tile are uploaded in addition, but not written back
+  tiled_executor(ocl_dev_mgr& dev_mgr, cl_uint context_idx, cl_ulong num_rows, cl_ulong tile_rows, cl_ulong halo);
+
+  void add_dataset(dataset const& data) { datasets.push_back(data); }
+  size_t num_datasets() const { return datasets.size(); }
+  void add_launch(launch const& item) { launches.push_back(item); }
+  size_t num_tiles() const { return (num_rows + tile_rows - 1) / tile_rows; }
+
+  // execute all launches `repetitions` times per tile and return the kernel execution time in µs
+  cl_ulong execute(h5_file const& config_file, h5_file const& out_file, cl_ulong repetitions, cl_ulong max_launch_range);
+
+  // timing of all executions of launch i, ordered by tile and repetition
+  std::vector<std::vector<exec_plan::launch_timing>> const& get_launch_times() const { return launch_times; }
+
+  // HDF5 and transfer times of dataset i, summed over all tiles (including the halos)
+  std::vector<h5_transfer_record> const& get_transfer_records() const { return transfer_records; }
+
+private:
+  struct tile {
+    cl_ulong row_start, row_end;       // rows processed
+    cl_ulong buffer_start, buffer_end; // rows in the buffers, including the halo
+    exec_plan plan;
+    std::vector<cl::Event> upload_events;
+  };
+
+  bool upload(h5_file const& config_file, size_t tile_idx);
+  void enqueue(size_t tile_idx, cl_ulong repetitions, cl_ulong max_launch_range);
+  cl_ulong download(h5_file const& out_file, size_t tile_idx);
+
+  ocl_dev_mgr& dev_mgr;
+  cl_uint context_idx;
+  cl_ulong num_rows;
+  cl_ulong tile_rows;
+  cl_ulong halo;
+
+  std::vector<dataset> datasets;
+  std::vector<launch> launches;
+  std::vector<cl::Buffer> buffers[2];
+  tile tiles[2];
+  std::vector<std::vector<exec_plan::launch_timing>> launch_times;
+  Timer timer;
+  std::vector<h5_transfer_record> transfer_records;
+  std::vector<std::vector<cl::Event>> upload_events;   // per dataset, profiled after the last tile
+  std::vector<std::vector<cl::Event>> readback_events; // per dataset
+};
+
+#endif // TILING_H
@@ -11,6 +11,7 @@
 typedef cl_ulong uint64_t;
 #else
 #include <stdint.h>
+#include <time.h>
 #include <unistd.h>
 #endif
 
@@ -0,0 +1,69 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <string>
+#include <vector>
+
+#include "opencl_include.hpp"
+#include "ocl_dev_mgr.hpp"
+#include "timer.hpp"
+
+
+// Timeline of a run in the Chrome trace event format (JSON), which can be opened with
+// chrome://tracing or Perfetto. All times are given in ns of the host `Timer`; the timestamps of
+// the device commands are converted to host time by clock calibrations of each device.
+class trace_writer {
+public:
+  explicit trace_writer(Timer& timer) : timer(timer) {}
+
+  // current host time in ns
+  cl_ulong now() { return timer.getTimeNanoseconds(); }
+
+  // stage of the host thread from `begin` to `end`
+  void add_host_stage(std::string const& name, std::string const& category, cl_ulong begin, cl_ulong end);
+
+  // command on queue `queue_idx` of context `context_idx` with its device timestamps
+  void add_device_command(cl_uint context_idx, cl_uint queue_idx, std::string const& name, std::string const& category,
+                          ocl_dev_mgr::profiling_info const& profile);
+
+  // sample of the sensor `name`, e.g. the power consumption
+  void add_counter(std::string const& name, cl_ulong time, double value);
+
+  void set_device_name(cl_uint context_idx, std::string const& name);
+
+  // Compare the device clock of context `context_idx` to the host clock using a marker on the
+  // (idle) queue `queue_idx`. The device timestamps are converted with the offset of the nearest
+  // calibration, interpolated linearly in between to account for drift.
+  bool calibrate(ocl_dev_mgr& dev_mgr, cl_uint context_idx, cl_uint queue_idx = 0);
+
+  bool write(std::string const& filename) const;
+
+private:
+  struct event {
+    std::string name;
+    std::string category;
+    char phase;         // 'X' = complete event, 'C' = counter
+    cl_uint pid, tid;   // process 0 = host, process i + 1 = context i
+    cl_ulong time;      // host (or device) time in ns
+    cl_ulong duration;
+    double value;
+    bool device_time;   // `time` is given in device time
+    ocl_dev_mgr::profiling_info profile;
+  };
+
+  struct calibration {
+    cl_ulong device_time;
+    double offset;      // host time - device time in ns
+  };
+
+  double host_time(cl_uint context_idx, cl_ulong device_time) const;
+
+  Timer& timer;
+  std::vector<event> events;
+  std::vector<std::vector<calibration>> calibrations; // per context
+  std::vector<std::string> device_names;              // per context
+};
+
+#endif // TRACE_H
@@ -5,9 +5,13 @@
 
 #if defined(_WIN32)
 #include <io.h>
+#include <direct.h>
 #define access _access_s
+#include <malloc.h>
 #else
+#include <stdlib.h>
 #include <unistd.h>
+#include <sys/stat.h>
 #endif
 
 
@@ -29,5 +33,48 @@ inline bool fileExists(std::string const& filename)
   return fileExists(filename.c_str());
 }
 
+// create a directory if it does not exist
+inline bool createDir(char const* dirname)
+{
+  if (fileExists(dirname)) {
+    return true;
+  }
+#if defined(_WIN32)
+  return _mkdir(dirname) == 0;
+#else
+  return mkdir(dirname, 0755) == 0;
+#endif
+}
+
+inline bool createDir(std::string const& dirname)
+{
+  return createDir(dirname.c_str());
+}
+
+
+// aligned host memory, e.g. page-aligned arrays for zero-copy buffers
+inline void* aligned_malloc(size_t size, size_t alignment)
+{
+#if defined(_WIN32)
+  return _aligned_malloc(size, alignment);
+#else
+  void* ptr = nullptr;
+  return posix_memalign(&ptr, alignment, size) == 0 ? ptr : nullptr;
+#endif
+}
+
+inline void aligned_free(void* ptr)
+{
+#if defined(_WIN32)
+  _aligned_free(ptr);
+#else
+  free(ptr);
+#endif
+}
+
+struct aligned_deleter {
+  void operator()(void* ptr) const { aligned_free(ptr); }
+};
+
 
 #endif // UTIL_H
@@ -0,0 +1,274 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include "exec_plan.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "util.hpp"
+
+
+void exec_plan::add_launch(cl::Kernel* kernel, cl::CommandQueue* queue,
+                           cl_ulong const* range_start, cl_ulong const* global_range, cl_ulong const* local_range,
+                           cl_ulong max_range, std::vector<cl_uint> const& buffers)
+{
+  launch tmp_launch;
+  tmp_launch.kernel = kernel;
+  tmp_launch.queue = queue;
+  tmp_launch.buffers = buffers;
+  tmp_launch.first_event = parts_per_repetition;
+
+  bool local_null = (local_range[0] == 0 && local_range[1] == 0 && local_range[2] == 0);
+  if (local_null) {
+    tmp_launch.local_range = cl::NullRange;
+  }
+  else {
+    tmp_launch.local_range = cl::NDRange(local_range[0], local_range[1], local_range[2]);
+  }
+
+  // the parts are multiples of the work-group size, such that the work-groups are not changed
+  cl_ulong chunk[3];
+  cl_ulong num_chunks[3];
+  for (cl_uint dim = 0; dim < 3; dim++) {
+    cl_ulong group = local_null ? 1 : std::max<cl_ulong>(local_range[dim], 1);
+    chunk[dim] = std::max<cl_ulong>(max_range / group, 1) * group;
+    num_chunks[dim] = std::max<cl_ulong>(global_range[dim] / chunk[dim] + (global_range[dim] % chunk[dim] != 0), 1);
+  }
+
+  for (cl_ulong k2 = 0; k2 < num_chunks[2]; k2++) {
+    for (cl_ulong k1 = 0; k1 < num_chunks[1]; k1++) {
+      for (cl_ulong k0 = 0; k0 < num_chunks[0]; k0++) {
+        cl_ulong k[3] = {k0, k1, k2};
+        cl_ulong start[3];
+        cl_ulong size[3];
+        for (cl_uint dim = 0; dim < 3; dim++) {
+          start[dim] = range_start[dim] + k[dim] * chunk[dim];
+          size[dim] = std::min(chunk[dim], global_range[dim] - std::min(global_range[dim], k[dim] * chunk[dim]));
+        }
+
+        launch_part part;
+        part.range_start = cl::NDRange(start[0], start[1], start[2]);
+        part.global_range = cl::NDRange(size[0], size[1], size[2]);
+        tmp_launch.parts.push_back(part);
+      }
+    }
+  }
+
+  parts_per_repetition += tmp_launch.parts.size();
+  launches.push_back(tmp_launch);
+}
+
+
+static bool uses_buffer(exec_plan::launch const& item, cl_uint buffer_idx)
+{
+  return std::find(item.buffers.begin(), item.buffers.end(), buffer_idx) != item.buffers.end();
+}
+
+
+// later launches are ordered by the in-order queue, hence only the first user has to wait
+void exec_plan::add_buffer_dependency(cl_uint buffer_idx, cl::Event const& event)
+{
+  for (launch& item : launches) {
+    if (uses_buffer(item, buffer_idx)) {
+      item.wait_events.push_back(event);
+      return;
+    }
+  }
+}
+
+
+void exec_plan::get_buffer_events(cl_uint buffer_idx, std::vector<cl::Event>& events) const
+{
+  events.clear();
+  if (enqueued_repetitions == 0) {
+    return;
+  }
+
+  // the last part of the last execution of the last launch accessing the buffer
+  size_t last_offset = (enqueued_repetitions - 1) * parts_per_repetition;
+  for (size_t idx = launches.size(); idx > 0; --idx) {
+    launch const& item = launches.at(idx - 1);
+    if (uses_buffer(item, buffer_idx)) {
+      events.push_back(kernel_events.at(last_offset + item.first_event + item.parts.size() - 1));
+      return;
+    }
+  }
+}
+
+
+// launches accessing one of the buffers access both of them, which keeps the
+// upload and readback dependencies valid independent of the number of swaps
+void exec_plan::add_swap(cl_uint buffer_a_idx, cl::Buffer* buffer_a, std::vector<arg_target> const& targets_a,
+                         cl_uint buffer_b_idx, cl::Buffer* buffer_b, std::vector<arg_target> const& targets_b)
+{
+  swap tmp_swap;
+  tmp_swap.buffer_a = buffer_a;
+  tmp_swap.buffer_b = buffer_b;
+  tmp_swap.targets_a = targets_a;
+  tmp_swap.targets_b = targets_b;
+  tmp_swap.swapped = false;
+
+  swaps.push_back(tmp_swap);
+
+  for (launch& item : launches) {
+    bool uses_a = uses_buffer(item, buffer_a_idx);
+    bool uses_b = uses_buffer(item, buffer_b_idx);
+    if (uses_a && !uses_b) {
+      item.buffers.push_back(buffer_b_idx);
+    }
+    else if (uses_b && !uses_a) {
+      item.buffers.push_back(buffer_a_idx);
+    }
+  }
+}
+
+
+// the arguments are captured when a launch is enqueued, hence swapping is valid in asynchronous mode
+void exec_plan::apply_swaps()
+{
+  try {
+    for (swap& item : swaps) {
+      item.swapped = !item.swapped;
+      for (arg_target const& target : item.targets_a) {
+        target.kernel->setArg(target.arg_idx, item.swapped ? *(item.buffer_b) : *(item.buffer_a));
+      }
+      for (arg_target const& target : item.targets_b) {
+        target.kernel->setArg(target.arg_idx, item.swapped ? *(item.buffer_a) : *(item.buffer_b));
+      }
+    }
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception:" << err.what() << std::endl;
+  }
+
+  ++swap_count;
+}
+
+
+// return execution time in µs
+cl_ulong exec_plan::execute(ocl_dev_mgr& dev_mgr, cl_ulong repetitions, bool async_mode)
+{
+  cl_ulong exec_time = 0;
+
+  // the durations are collected without any allocations in the repetition loop
+  launch_times.assign(launches.size() * repetitions, launch_timing());
+  timed_repetitions = repetitions;
+
+  if (async_mode == true) {
+    // the queues are in-order, hence the launches are still executed one after another,
+    // but the host does not wait for each launch and pays only a single round-trip
+    kernel_events.assign(parts_per_repetition * repetitions, cl::Event());
+    size_t event_idx = 0;
+
+    for (cl_ulong repetition = 0; repetition < repetitions; ++repetition) {
+      for (launch& item : launches) {
+        // later parts are ordered by the in-order queue
+        std::vector<cl::Event> const* wait_events = (repetition == 0 && !item.wait_events.empty()) ? &item.wait_events : NULL;
+        for (launch_part const& part : item.parts) {
+          dev_mgr.enqueue_kernelNA(*(item.kernel), *(item.queue), part.range_start, part.global_range, item.local_range,
+                                   &kernel_events[event_idx++], wait_events);
+          wait_events = NULL;
+        }
+      }
+
+      if (!swaps.empty() && (repetition + 1) % swap_interval == 0 && repetition + 1 < repetitions) {
+        apply_swaps();
+      }
+    }
+
+    for (launch& item : launches) {
+      item.queue->flush();
+    }
+    enqueued_repetitions = repetitions;
+  }
+  else {
+    for (cl_ulong repetition = 0; repetition < repetitions; ++repetition) {
+      for (size_t launch_idx = 0; launch_idx < launches.size(); launch_idx++) {
+        launch& item = launches[launch_idx];
+        std::vector<cl::Event> const* wait_events = (repetition == 0 && !item.wait_events.empty()) ? &item.wait_events : NULL;
+        for (size_t part_idx = 0; part_idx < item.parts.size(); part_idx++) {
+          launch_part const& part = item.parts[part_idx];
+          ocl_dev_mgr::profiling_info part_profile = {0, 0, 0, 0};
+          exec_time += dev_mgr.execute_kernelNA(*(item.kernel), *(item.queue), part.range_start, part.global_range, item.local_range,
+                                                wait_events, &part_profile);
+          add_part_timing(launch_times[repetition * launches.size() + launch_idx], part_profile, part_idx == 0);
+          wait_events = NULL;
+        }
+      }
+
+      if (!swaps.empty() && (repetition + 1) % swap_interval == 0 && repetition + 1 < repetitions) {
+        apply_swaps();
+      }
+    }
+  }
+
+  return exec_time;
+}
+
+
+// wait for launches enqueued in asynchronous mode and return their execution time in µs
+cl_ulong exec_plan::finish(ocl_dev_mgr& dev_mgr)
+{
+  if (enqueued_repetitions == 0) {
+    return 0;
+  }
+
+  // only the own launches are waited for, other commands in the queues may still be running
+  try {
+    cl::Event::waitForEvents(kernel_events);
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception:" << err.what() << std::endl;
+  }
+  cl_ulong exec_time = dev_mgr.get_profiling_time(kernel_events);
+
+  for (cl_ulong repetition = 0; repetition < enqueued_repetitions; ++repetition) {
+    for (size_t launch_idx = 0; launch_idx < launches.size(); launch_idx++) {
+      launch const& item = launches[launch_idx];
+      for (size_t part_idx = 0; part_idx < item.parts.size(); part_idx++) {
+        ocl_dev_mgr::profiling_info part_profile = {0, 0, 0, 0};
+        dev_mgr.get_profiling_info(kernel_events[repetition * parts_per_repetition + item.first_event + part_idx], part_profile);
+        add_part_timing(launch_times[repetition * launches.size() + launch_idx], part_profile, part_idx == 0);
+      }
+    }
+  }
+
+  kernel_events.clear();
+  enqueued_repetitions = 0;
+
+  return exec_time;
+}
+
+
+// the parts of a launch are executed one after another by the in-order queue
+void exec_plan::add_part_timing(launch_timing& timing, ocl_dev_mgr::profiling_info const& part_profile, bool first_part)
+{
+  if (first_part) {
+    timing.duration = 0;
+    timing.profile = part_profile;
+  }
+  timing.profile.end = part_profile.end;
+  timing.duration += part_profile.end - part_profile.start;
+}
+
+
+cl_ulong exec_plan::get_device_span() const
+{
+  cl_ulong first_start = ~(cl_ulong)0, last_end = 0;
+  for (launch_timing const& timing : launch_times) {
+    first_start = std::min(first_start, timing.profile.start);
+    last_end = std::max(last_end, timing.profile.end);
+  }
+  return last_end > first_start ? (last_end - first_start) / 1000 : 0;
+}
+
+
+void exec_plan::append_launch_times(std::vector<std::vector<launch_timing>>& times) const
+{
+  times.resize(std::max(times.size(), launches.size()));
+  for (cl_ulong repetition = 0; repetition < timed_repetitions; ++repetition) {
+    for (size_t launch_idx = 0; launch_idx < launches.size(); launch_idx++) {
+      times.at(launch_idx).push_back(launch_times.at(repetition * launches.size() + launch_idx));
+    }
+  }
+}
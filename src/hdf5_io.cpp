@@ -2,13 +2,18 @@
 
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iostream>
+#include <mutex>
 #include <numeric>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "hdf5.h"
 #include "hdf5_hl.h"
+#include "zlib.h"
 
 #include "opencl_include.hpp"
 
@@ -91,39 +96,96 @@ template<typename TYPE>
 constexpr size_t get_vector_size() { return 1; };
 
 
+h5_file::h5_file(char const* filename, access_mode mode)
+  : filename(filename), h5_file_id(-1)
+{
+  if (mode == truncate || (mode == read_write && !fileExists(filename))) {
+    h5_file_id = H5Fcreate(filename, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+  }
+  else if (fileExists(filename)) {
+    h5_file_id = H5Fopen(filename, mode == read_only ? H5F_ACC_RDONLY : H5F_ACC_RDWR, H5P_DEFAULT);
+  }
+  else {
+    std::cerr << ERROR_INFO << "File '" << filename << "' not found." << std::endl;
+    return;
+  }
+
+  if (h5_file_id < 0) {
+    std::cerr << ERROR_INFO << "Opening file '" << filename << "' not possible." << std::endl;
+  }
+}
+
+h5_file::h5_file(std::string const& filename, access_mode mode)
+  : h5_file(filename.c_str(), mode)
+{
+}
+
+h5_file::~h5_file()
+{
+  close();
+}
+
+void h5_file::close()
+{
+  if (h5_file_id >= 0) {
+    H5Fclose(h5_file_id);
+    h5_file_id = -1;
+  }
+}
+
+void h5_file::flush() const
+{
+  if (h5_file_id >= 0) {
+    H5Fflush(h5_file_id, H5F_SCOPE_LOCAL);
+  }
+}
+
+
+bool h5_check_object(h5_file const& file, char const* varname)
+{
+  if (!file.is_open()) {
+    return false;
+  }
+
+  return H5LTpath_valid(file.id(), varname, true) > 0;
+}
+
 bool h5_check_object(char const* filename, char const* varname)
 {
-	hid_t h5_file_id;
+  h5_file file(filename, h5_file::read_only);
+  return h5_check_object(file, varname);
+}
 
-  if (fileExists(filename)) {
-    h5_file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
 
-    if (H5LTpath_valid(h5_file_id, varname, true) > 0) {
-      H5Fclose(h5_file_id);
-      return true;
-    }
-    else {
-      H5Fclose(h5_file_id);
-      return false;
-    }
+bool h5_get_dims(h5_file const& file, char const* varname, std::vector<hsize_t>& dims)
+{
+  if (!h5_check_object(file, varname)) {
+    std::cerr << ERROR_INFO << "Variable '" << varname << "' not found in file '" << file.name() << "'." << std::endl;
+    return false;
   }
 
-  std::cerr << ERROR_INFO << "File '" << filename << "' not found." << std::endl;
-  return false;
+  hid_t dataset = H5Dopen(file.id(), varname, H5P_DEFAULT);
+  hid_t dataspace = H5Dget_space(dataset);
+  int ndims = H5Sget_simple_extent_ndims(dataspace);
+  dims.resize(ndims);
+  if (ndims > 0) {
+    H5Sget_simple_extent_dims(dataspace, &(dims[0]), NULL);
+  }
+  H5Sclose(dataspace);
+  H5Dclose(dataset);
+
+  return true;
 }
 
 
-bool h5_get_content(char const* filename, char const* hdf_dir,
+bool h5_get_content(h5_file const& file, char const* hdf_dir,
                     std::vector<std::string>& data_names, std::vector<HD5_Type>& data_types, std::vector<size_t>& data_sizes)
 {
-  if (!fileExists(filename)) {
-    std::cerr << ERROR_INFO << "File '" << filename << "' not found." << std::endl;
+  if (!file.is_open()) {
     return false;
   }
 
-  hid_t h5_file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
-  hid_t grp = H5Gopen(h5_file_id, hdf_dir, H5P_DEFAULT);
-
+  hid_t grp = H5Gopen(file.id(), hdf_dir, H5P_DEFAULT);
   hsize_t nobj;
   H5Gget_num_objs(grp, &nobj);
 
@@ -190,26 +252,62 @@ bool h5_get_content(char const* filename, char const* hdf_dir,
   }
 
   H5Gclose(grp);
-  H5Fclose(h5_file_id);
 
   return true;
 }
 
+bool h5_get_content(char const* filename, char const* hdf_dir,
+                    std::vector<std::string>& data_names, std::vector<HD5_Type>& data_types, std::vector<size_t>& data_sizes)
+{
+  h5_file file(filename, h5_file::read_only);
+  return h5_get_content(file, hdf_dir, data_names, data_types, data_sizes);
+}
+
+
+bool h5_create_dir(h5_file const& file, char const* hdf_dir)
+{
+  if (!file.is_open()) {
+    return false;
+  }
+
+  hid_t grp = H5Gcreate1(file.id(), hdf_dir, 0);
+  H5Gclose(grp);
+
+  return true;
+}
 
 bool h5_create_dir(char const* filename, char const* hdf_dir)
 {
-  hid_t h5_file_id, grp;
+  if (!fileExists(filename)) {
+    return false;
+  }
 
-  if (fileExists(filename)) {
-    h5_file_id = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT);
+  h5_file file(filename, h5_file::read_write);
+  return h5_create_dir(file, hdf_dir);
+}
+
+
+// the (compressed) raw data are copied as is, without decoding and encoding them again
+bool h5_copy_object(h5_file const& src_file, h5_file const& dst_file, char const* varname)
+{
+  if (!src_file.is_open() || !dst_file.is_open()) {
+    return false;
   }
-  else {
+
+  if (!h5_check_object(src_file, varname)) {
+    std::cerr << ERROR_INFO << "Variable '" << varname << "' not found in file '" << src_file.name() << "'." << std::endl;
     return false;
   }
 
-  grp = H5Gcreate1(h5_file_id, hdf_dir, 0);
-  H5Gclose(grp);
-  H5Fclose(h5_file_id);
+  hid_t lcpl = H5Pcreate(H5P_LINK_CREATE);
+  H5Pset_create_intermediate_group(lcpl, 1);
+  herr_t status = H5Ocopy(src_file.id(), varname, dst_file.id(), varname, H5P_DEFAULT, lcpl);
+  H5Pclose(lcpl);
+
+  if (status < 0) {
+    std::cerr << ERROR_INFO << "Copying '" << varname << "' to file '" << dst_file.name() << "' failed." << std::endl;
+    return false;
+  }
 
   return true;
 }
@@ -217,78 +315,197 @@ bool h5_create_dir(char const* filename, char const* hdf_dir)
 
 // read a buffer from an HDF5 file
 template<typename TYPE>
-bool h5_read_buffer(char const* filename, char const* varname, TYPE* data)
+bool h5_read_buffer(h5_file const& file, char const* varname, TYPE* data)
 {
-  if (!fileExists(filename)) {
-    std::cerr << ERROR_INFO << "File '" << filename << "' not found." << std::endl;
+  if (!file.is_open()) {
     //TODO: Exception? Only error code?
     return false;
   }
 
-  hid_t h5_file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
-  if (H5LTpath_valid(h5_file_id, varname, true) <= 0) {
-    std::cerr << ERROR_INFO << "Variable '" << varname << "' not found in file '" << filename << "'." << std::endl;
+  if (H5LTpath_valid(file.id(), varname, true) <= 0) {
+    std::cerr << ERROR_INFO << "Variable '" << varname << "' not found in file '" << file.name() << "'." << std::endl;
     //TODO: Exception? Only error code?
-    H5Fclose(h5_file_id);
     return false;
   }
 
-  herr_t err = H5LTread_dataset(h5_file_id, varname, type_to_h5_type<TYPE>(), data);
+  herr_t err = H5LTread_dataset(file.id(), varname, type_to_h5_type<TYPE>(), data);
   if (err < 0) {
-    std::cerr << ERROR_INFO << "Reading variable '" << varname << "' in file '" << filename << "' not possible." << std::endl;
+    std::cerr << ERROR_INFO << "Reading variable '" << varname << "' in file '" << file.name() << "' not possible." << std::endl;
     //TODO: Exception? Only error code?
-    H5Fclose(h5_file_id);
     return false;
   }
 
-  H5Fclose(h5_file_id);
   return true;
 }
 
 // template instantiations
-template bool h5_read_buffer(char const* filename, char const* varname, float* data);
-template bool h5_read_buffer(char const* filename, char const* varname, double* data);
-template bool h5_read_buffer(char const* filename, char const* varname, cl_char* data);
-template bool h5_read_buffer(char const* filename, char const* varname, cl_uchar* data);
-template bool h5_read_buffer(char const* filename, char const* varname, cl_short* data);
-template bool h5_read_buffer(char const* filename, char const* varname, cl_ushort* data);
-template bool h5_read_buffer(char const* filename, char const* varname, cl_int* data);
-template bool h5_read_buffer(char const* filename, char const* varname, cl_uint* data);
-template bool h5_read_buffer(char const* filename, char const* varname, cl_long* data);
-template bool h5_read_buffer(char const* filename, char const* varname, cl_ulong* data);
+template bool h5_read_buffer(h5_file const& file, char const* varname, float* data);
+template bool h5_read_buffer(h5_file const& file, char const* varname, double* data);
+template bool h5_read_buffer(h5_file const& file, char const* varname, cl_char* data);
+template bool h5_read_buffer(h5_file const& file, char const* varname, cl_uchar* data);
+template bool h5_read_buffer(h5_file const& file, char const* varname, cl_short* data);
+template bool h5_read_buffer(h5_file const& file, char const* varname, cl_ushort* data);
+template bool h5_read_buffer(h5_file const& file, char const* varname, cl_int* data);
+template bool h5_read_buffer(h5_file const& file, char const* varname, cl_uint* data);
+template bool h5_read_buffer(h5_file const& file, char const* varname, cl_long* data);
+template bool h5_read_buffer(h5_file const& file, char const* varname, cl_ulong* data);
+
+
+// Compress the chunks of a dataset of size `hdf_dims` on several threads and write them
+// using direct chunk writes, bypassing the single threaded HDF5 filter pipeline. The
+// chunks are encoded exactly as the HDF5 shuffle and deflate filters would do, such
+// that the file can be read by any HDF5 tool. Chunks have to span the second dimension.
+static bool h5_write_chunks_parallel(hid_t dataset_id, void const* data, hsize_t const* hdf_dims, hsize_t const* cdims,
+                                     size_t type_size, h5_compression const& compression)
+{
+  size_t row_size = hdf_dims[1] * type_size;
+  size_t chunk_size = cdims[0] * row_size;
+  size_t num_chunks = (hdf_dims[0] + cdims[0] - 1) / cdims[0];
+  bool shuffle = (compression.filter == h5_compression::shuffle_deflate) && type_size > 1;
+  int deflate_level = std::min(std::max(compression.level, 0), 9);
+
+  std::atomic<size_t> next_chunk(0);
+  std::atomic<bool> success(true);
+  std::mutex h5_mutex; // HDF5 itself is not thread safe
+
+  auto worker = [&]() {
+    std::vector<unsigned char> raw(chunk_size);
+    std::vector<unsigned char> shuffled(shuffle ? chunk_size : 0);
+    std::vector<unsigned char> compressed(compressBound(chunk_size));
+
+    for (size_t chunk = next_chunk++; chunk < num_chunks; chunk = next_chunk++) {
+      // edge chunks are stored with the full chunk size
+      size_t first_row = chunk * cdims[0];
+      size_t num_rows = std::min<size_t>(cdims[0], hdf_dims[0] - first_row);
+      memcpy(raw.data(), (unsigned char const*)data + first_row * row_size, num_rows * row_size);
+      std::fill(raw.begin() + num_rows * row_size, raw.end(), 0);
+
+      unsigned char const* input = raw.data();
+      if (shuffle) {
+        size_t num_elements = chunk_size / type_size;
+        for (size_t byte = 0; byte < type_size; ++byte) {
+          for (size_t element = 0; element < num_elements; ++element) {
+            shuffled[byte * num_elements + element] = raw[element * type_size + byte];
+          }
+        }
+        input = shuffled.data();
+      }
+
+      uLongf compressed_size = compressed.size();
+      if (compress2(compressed.data(), &compressed_size, input, chunk_size, deflate_level) != Z_OK) {
+        success = false;
+        continue;
+      }
+
+      hsize_t offset[2] = {first_row, 0};
+      std::lock_guard<std::mutex> lock(h5_mutex);
+#if H5_VERSION_GE(1, 10, 3)
+      herr_t err = H5Dwrite_chunk(dataset_id, H5P_DEFAULT, 0, offset, compressed_size, compressed.data());
+#else
+      herr_t err = H5DOwrite_chunk(dataset_id, H5P_DEFAULT, 0, offset, compressed_size, compressed.data());
+#endif
+      if (err < 0) {
+        success = false;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t thread_idx = 0; thread_idx < std::min<size_t>(compression.threads, num_chunks); ++thread_idx) {
+    workers.push_back(std::thread(worker));
+  }
+  for (std::thread& thread : workers) {
+    thread.join();
+  }
+
+  return success;
+}
+
+
+// dataset creation property list of a 2D dataset with the dimensions `hdf_dims` applying the
+// compression policy; the chunk dimensions are returned in `cdims`
+static hid_t h5_create_dcpl(hid_t type_id, hsize_t const* hdf_dims, hsize_t* cdims, h5_compression const& compression)
+{
+  if (compression.chunk.empty()) {
+    cdims[0] = (hsize_t)(hdf_dims[0]/chunk_factor) + 1;
+    cdims[1] = hdf_dims[1];
+  }
+  else {
+    // chunks must not be larger than the dataset itself
+    cdims[0] = std::max<hsize_t>(1, std::min<hsize_t>(compression.chunk.at(0), hdf_dims[0]));
+    cdims[1] = hdf_dims[1];
+    if (compression.chunk.size() > 1) {
+      cdims[1] = std::max<hsize_t>(1, std::min<hsize_t>(compression.chunk.at(1), hdf_dims[1]));
+    }
+  }
+  // chunks are limited to 4 GB by HDF5
+  cdims[0] = std::max<hsize_t>(1, std::min<hsize_t>(cdims[0], 0xFFFFFFFFu / (H5Tget_size(type_id) * cdims[1])));
+
+  hid_t plist_id = H5Pcreate(H5P_DATASET_CREATE);
+  if (compression.filter != h5_compression::none || !compression.chunk.empty()) {
+    H5Pset_chunk(plist_id, 2, cdims);
+  }
+
+  unsigned int deflate_level = std::min(std::max(compression.level, 0), 9);
+  switch (compression.filter) {
+    case h5_compression::none:
+      break;
+    case h5_compression::deflate:
+      H5Pset_deflate(plist_id, deflate_level);
+      break;
+    case h5_compression::shuffle_deflate:
+      H5Pset_shuffle(plist_id);
+      H5Pset_deflate(plist_id, deflate_level);
+      break;
+    case h5_compression::scaleoffset:
+      if (H5Tget_class(type_id) == H5T_FLOAT) {
+        // lossy: keep `level` decimal digits
+        H5Pset_scaleoffset(plist_id, H5Z_SO_FLOAT_DSCALE, compression.level);
+      }
+      else {
+        // lossless: the minimal number of bits is computed by HDF5
+        H5Pset_scaleoffset(plist_id, H5Z_SO_INT, H5Z_SO_INT_MINBITS_DEFAULT);
+      }
+      break;
+  }
+
+  return plist_id;
+}
 
 
 // write a buffer to an HDF5 file using compression
 template<typename TYPE>
-bool h5_write_buffer(char const* filename, char const* varname, TYPE const* data, size_t size)
+bool h5_write_buffer(h5_file const& file, char const* varname, TYPE const* data, size_t size,
+                     h5_compression const& compression)
 {
-  hid_t   h5_file_id, dataset_id, dataspace_id, memspace_id;
+  hid_t   dataset_id, dataspace_id, memspace_id;
   hsize_t hdf_dims[2];
   hid_t   plist_id;
   hsize_t cdims[2]; //chunk size used for compression
 
-  if (!fileExists(filename)) {
-    h5_file_id = H5Fcreate(filename, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
-  }
-  else {
-    h5_file_id = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT);
+  if (!file.is_open()) {
+    return false;
   }
 
   hdf_dims[0] = size;
   hdf_dims[1] = get_vector_size<TYPE>();
-
-  cdims[0] = (hsize_t)(hdf_dims[0]/chunk_factor) + 1;
-  cdims[1] = hdf_dims[1];
-
-  plist_id = H5Pcreate(H5P_DATASET_CREATE);
-  H5Pset_chunk(plist_id, 2, cdims);
-  H5Pset_deflate(plist_id, 9);
+  plist_id = h5_create_dcpl(type_to_h5_type<TYPE>(), hdf_dims, cdims, compression);
 
   dataspace_id = H5Screate_simple(2, hdf_dims, NULL);
   memspace_id = H5Screate_simple(2, hdf_dims, NULL);
-  dataset_id = H5Dcreate2(h5_file_id, varname , type_to_h5_type<TYPE>(), dataspace_id, H5P_DEFAULT, plist_id, H5P_DEFAULT);
+  dataset_id = H5Dcreate2(file.id(), varname , type_to_h5_type<TYPE>(), dataspace_id, H5P_DEFAULT, plist_id, H5P_DEFAULT);
 
-  H5Dwrite(dataset_id, type_to_h5_type<TYPE>(), memspace_id, dataspace_id, H5P_DEFAULT, data);
+  bool parallel_chunks = compression.threads > 1 && hdf_dims[0] > cdims[0] && cdims[1] == hdf_dims[1] &&
+                         (compression.filter == h5_compression::deflate || compression.filter == h5_compression::shuffle_deflate);
+
+  if (parallel_chunks) {
+    if (!h5_write_chunks_parallel(dataset_id, data, hdf_dims, cdims, H5Tget_size(type_to_h5_type<TYPE>()), compression)) {
+      std::cerr << ERROR_INFO << "Writing variable '" << varname << "' in file '" << file.name() << "' not possible." << std::endl;
+    }
+  }
+  else {
+    H5Dwrite(dataset_id, type_to_h5_type<TYPE>(), memspace_id, dataspace_id, H5P_DEFAULT, data);
+  }
   // The same can be done using H5 High Level API, but without compression
   // H5LTmake_dataset(h5_file_id, varname, 2, hdf_dims, type_to_h5_type<TYPE>(), data);
 
@@ -297,25 +514,324 @@ bool h5_write_buffer(char const* filename, char const* varname, TYPE const* data
   H5Sclose(memspace_id);
   H5Dclose(dataset_id);
 
-  H5Fclose(h5_file_id);
-
   return true;
 }
 
 // template instantiations
-template bool h5_write_buffer(char const* filename, char const* varname, float const* data, size_t size);
-template bool h5_write_buffer(char const* filename, char const* varname, double const* data, size_t size);
-template bool h5_write_buffer(char const* filename, char const* varname, cl_char const* data, size_t size);
-template bool h5_write_buffer(char const* filename, char const* varname, cl_uchar const* data, size_t size);
-template bool h5_write_buffer(char const* filename, char const* varname, cl_short const* data, size_t size);
-template bool h5_write_buffer(char const* filename, char const* varname, cl_ushort const* data, size_t size);
-template bool h5_write_buffer(char const* filename, char const* varname, cl_int const* data, size_t size);
-template bool h5_write_buffer(char const* filename, char const* varname, cl_uint const* data, size_t size);
-template bool h5_write_buffer(char const* filename, char const* varname, cl_long const* data, size_t size);
-template bool h5_write_buffer(char const* filename, char const* varname, cl_ulong const* data, size_t size);
+template bool h5_write_buffer(h5_file const& file, char const* varname, float const* data, size_t size, h5_compression const& compression);
+template bool h5_write_buffer(h5_file const& file, char const* varname, double const* data, size_t size, h5_compression const& compression);
+template bool h5_write_buffer(h5_file const& file, char const* varname, cl_char const* data, size_t size, h5_compression const& compression);
+template bool h5_write_buffer(h5_file const& file, char const* varname, cl_uchar const* data, size_t size, h5_compression const& compression);
+template bool h5_write_buffer(h5_file const& file, char const* varname, cl_short const* data, size_t size, h5_compression const& compression);
+template bool h5_write_buffer(h5_file const& file, char const* varname, cl_ushort const* data, size_t size, h5_compression const& compression);
+template bool h5_write_buffer(h5_file const& file, char const* varname, cl_int const* data, size_t size, h5_compression const& compression);
+template bool h5_write_buffer(h5_file const& file, char const* varname, cl_uint const* data, size_t size, h5_compression const& compression);
+template bool h5_write_buffer(h5_file const& file, char const* varname, cl_long const* data, size_t size, h5_compression const& compression);
+template bool h5_write_buffer(h5_file const& file, char const* varname, cl_ulong const* data, size_t size, h5_compression const& compression);
+
+
+
 
+size_t h5_type_size(HD5_Type type)
+{
+  switch (type) {
+    case H5_float:  return sizeof(cl_float);
+    case H5_double: return sizeof(cl_double);
+    case H5_char:   return sizeof(cl_char);
+    case H5_uchar:  return sizeof(cl_uchar);
+    case H5_short:  return sizeof(cl_short);
+    case H5_ushort: return sizeof(cl_ushort);
+    case H5_int:    return sizeof(cl_int);
+    case H5_uint:   return sizeof(cl_uint);
+    case H5_long:   return sizeof(cl_long);
+    case H5_ulong:  return sizeof(cl_ulong);
+  }
+
+  std::cerr << ERROR_INFO << "Data type '" << type << "' unknown." << std::endl;
+  return 0;
+}
+
+
+bool h5_read_buffer(h5_file const& file, char const* varname, HD5_Type type, void* data)
+{
+  switch (type) {
+    case H5_float:  return h5_read_buffer<cl_float>( file, varname, (cl_float*)data);
+    case H5_double: return h5_read_buffer<cl_double>(file, varname, (cl_double*)data);
+    case H5_char:   return h5_read_buffer<cl_char>(  file, varname, (cl_char*)data);
+    case H5_uchar:  return h5_read_buffer<cl_uchar>( file, varname, (cl_uchar*)data);
+    case H5_short:  return h5_read_buffer<cl_short>( file, varname, (cl_short*)data);
+    case H5_ushort: return h5_read_buffer<cl_ushort>(file, varname, (cl_ushort*)data);
+    case H5_int:    return h5_read_buffer<cl_int>(   file, varname, (cl_int*)data);
+    case H5_uint:   return h5_read_buffer<cl_uint>(  file, varname, (cl_uint*)data);
+    case H5_long:   return h5_read_buffer<cl_long>(  file, varname, (cl_long*)data);
+    case H5_ulong:  return h5_read_buffer<cl_ulong>( file, varname, (cl_ulong*)data);
+  }
+
+  std::cerr << ERROR_INFO << "Data type '" << type << "' unknown." << std::endl;
+  return false;
+}
 
 
+bool h5_write_buffer(h5_file const& file, char const* varname, HD5_Type type, void const* data, size_t size,
+                     h5_compression const& compression)
+{
+  switch (type) {
+    case H5_float:  return h5_write_buffer<cl_float>( file, varname, (cl_float const*)data,  size, compression);
+    case H5_double: return h5_write_buffer<cl_double>(file, varname, (cl_double const*)data, size, compression);
+    case H5_char:   return h5_write_buffer<cl_char>(  file, varname, (cl_char const*)data,   size, compression);
+    case H5_uchar:  return h5_write_buffer<cl_uchar>( file, varname, (cl_uchar const*)data,  size, compression);
+    case H5_short:  return h5_write_buffer<cl_short>( file, varname, (cl_short const*)data,  size, compression);
+    case H5_ushort: return h5_write_buffer<cl_ushort>(file, varname, (cl_ushort const*)data, size, compression);
+    case H5_int:    return h5_write_buffer<cl_int>(   file, varname, (cl_int const*)data,    size, compression);
+    case H5_uint:   return h5_write_buffer<cl_uint>(  file, varname, (cl_uint const*)data,   size, compression);
+    case H5_long:   return h5_write_buffer<cl_long>(  file, varname, (cl_long const*)data,   size, compression);
+    case H5_ulong:  return h5_write_buffer<cl_ulong>( file, varname, (cl_ulong const*)data,  size, compression);
+  }
+
+  std::cerr << ERROR_INFO << "Data type '" << type << "' unknown." << std::endl;
+  return false;
+}
+
+
+static hid_t h5_type_id(HD5_Type type)
+{
+  switch (type) {
+    case H5_float:  return type_to_h5_type<cl_float>();
+    case H5_double: return type_to_h5_type<cl_double>();
+    case H5_char:   return type_to_h5_type<cl_char>();
+    case H5_uchar:  return type_to_h5_type<cl_uchar>();
+    case H5_short:  return type_to_h5_type<cl_short>();
+    case H5_ushort: return type_to_h5_type<cl_ushort>();
+    case H5_int:    return type_to_h5_type<cl_int>();
+    case H5_uint:   return type_to_h5_type<cl_uint>();
+    case H5_long:   return type_to_h5_type<cl_long>();
+    case H5_ulong:  return type_to_h5_type<cl_ulong>();
+  }
+
+  std::cerr << ERROR_INFO << "Data type '" << type << "' unknown." << std::endl;
+  return -1;
+}
+
+
+// same layout as written by h5_write_buffer
+bool h5_create_buffer(h5_file const& file, char const* varname, HD5_Type type, size_t size,
+                      h5_compression const& compression)
+{
+  if (!file.is_open()) {
+    return false;
+  }
+
+  hsize_t hdf_dims[2] = {size, 1};
+  hsize_t cdims[2];
+  hid_t plist_id = h5_create_dcpl(h5_type_id(type), hdf_dims, cdims, compression);
+  hid_t dataspace_id = H5Screate_simple(2, hdf_dims, NULL);
+  hid_t dataset_id = H5Dcreate2(file.id(), varname, h5_type_id(type), dataspace_id, H5P_DEFAULT, plist_id, H5P_DEFAULT);
+
+  H5Pclose(plist_id);
+  H5Sclose(dataspace_id);
+  if (dataset_id < 0) {
+    std::cerr << ERROR_INFO << "Creating variable '" << varname << "' in file '" << file.name() << "' not possible." << std::endl;
+    return false;
+  }
+  H5Dclose(dataset_id);
+
+  return true;
+}
+
+
+// read or write the rows [row_offset, row_offset + num_rows) of the slowest dimension of a dataset
+static bool h5_access_rows(h5_file const& file, char const* varname, HD5_Type type,
+                           hsize_t row_offset, hsize_t num_rows, void* data, bool write)
+{
+  if (!file.is_open()) {
+    return false;
+  }
+
+  if (H5LTpath_valid(file.id(), varname, true) <= 0) {
+    std::cerr << ERROR_INFO << "Variable '" << varname << "' not found in file '" << file.name() << "'." << std::endl;
+    return false;
+  }
+
+  hid_t dataset_id = H5Dopen(file.id(), varname, H5P_DEFAULT);
+  hid_t dataspace_id = H5Dget_space(dataset_id);
+  int ndims = H5Sget_simple_extent_ndims(dataspace_id);
+  std::vector<hsize_t> dims(std::max(ndims, 1), 1);
+  H5Sget_simple_extent_dims(dataspace_id, &(dims[0]), NULL);
+
+  std::vector<hsize_t> start(dims.size(), 0);
+  std::vector<hsize_t> count(dims);
+  start[0] = row_offset;
+  count[0] = num_rows;
+
+  herr_t err = -1;
+  if (row_offset + num_rows <= dims[0]) {
+    H5Sselect_hyperslab(dataspace_id, H5S_SELECT_SET, &(start[0]), NULL, &(count[0]), NULL);
+    hid_t memspace_id = H5Screate_simple(dims.size(), &(count[0]), NULL);
+    if (write) {
+      err = H5Dwrite(dataset_id, h5_type_id(type), memspace_id, dataspace_id, H5P_DEFAULT, data);
+    }
+    else {
+      err = H5Dread(dataset_id, h5_type_id(type), memspace_id, dataspace_id, H5P_DEFAULT, data);
+    }
+    H5Sclose(memspace_id);
+  }
+
+  H5Sclose(dataspace_id);
+  H5Dclose(dataset_id);
+
+  if (err < 0) {
+    std::cerr << ERROR_INFO << (write ? "Writing" : "Reading") << " rows " << row_offset << " to " << row_offset + num_rows
+              << " of variable '" << varname << "' in file '" << file.name() << "' not possible." << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool h5_read_rows(h5_file const& file, char const* varname, HD5_Type type, hsize_t row_offset, hsize_t num_rows, void* data)
+{
+  return h5_access_rows(file, varname, type, row_offset, num_rows, data, false);
+}
+
+bool h5_write_rows(h5_file const& file, char const* varname, HD5_Type type, hsize_t row_offset, hsize_t num_rows, void const* data)
+{
+  return h5_access_rows(file, varname, type, row_offset, num_rows, const_cast<void*>(data), true);
+}
+
+
+// compression policies
+char const* h5_compression_name(h5_compression::filter_type filter)
+{
+  switch (filter) {
+    case h5_compression::none:            return "none";
+    case h5_compression::deflate:         return "deflate";
+    case h5_compression::shuffle_deflate: return "shuffle_deflate";
+    case h5_compression::scaleoffset:     return "scaleoffset";
+  }
+
+  return "unknown";
+}
+
+bool h5_parse_compression(std::string const& name, h5_compression::filter_type& filter)
+{
+  // strings read from fixed length HDF5 strings may contain trailing null characters
+  std::string tmp_name(name.c_str());
+
+  for (h5_compression::filter_type tmp_filter : { h5_compression::none, h5_compression::deflate, h5_compression::shuffle_deflate,
+                                                  h5_compression::scaleoffset }) {
+    if (tmp_name == h5_compression_name(tmp_filter)) {
+      filter = tmp_filter;
+      return true;
+    }
+  }
+
+  // the datasets are written with native types, which use all of their bits
+  if (tmp_name == "nbit") {
+    std::cerr << ERROR_INFO << "Compression 'nbit' has no effect on the native types of the datasets, use 'none' or 'scaleoffset'." << std::endl;
+    return false;
+  }
+
+  std::cerr << ERROR_INFO << "Compression '" << tmp_name << "' unknown." << std::endl;
+  return false;
+}
+
+bool h5_read_compression(h5_file const& file, h5_compression& compression)
+{
+  if (h5_check_object(file, "Compression")) {
+    std::string name;
+    h5_read_string(file, "Compression", name);
+    if (!h5_parse_compression(name, compression.filter)) {
+      return false;
+    }
+  }
+
+  if (h5_check_object(file, "Compression_Level")) {
+    compression.level = h5_read_single<cl_int>(file, "Compression_Level");
+    compression.level_given = true;
+  }
+
+  if (h5_check_object(file, "Compression_Chunk")) {
+    std::vector<hsize_t> dims;
+    h5_get_dims(file, "Compression_Chunk", dims);
+    std::vector<cl_ulong> chunk(accumulate(begin(dims), end(dims), 1, std::multiplies<hsize_t>()));
+    h5_read_buffer<cl_ulong>(file, "Compression_Chunk", chunk.data());
+    compression.chunk.assign(chunk.begin(), chunk.end());
+  }
+
+  return true;
+}
+
+bool h5_write_compression(h5_file const& file, h5_compression const& compression)
+{
+  h5_write_string(file, "Compression", h5_compression_name(compression.filter));
+  h5_write_single<cl_int>(file, "Compression_Level", compression.level);
+
+  if (!compression.chunk.empty()) {
+    std::vector<cl_ulong> chunk(compression.chunk.begin(), compression.chunk.end());
+    h5_write_buffer<cl_ulong>(file, "Compression_Chunk", chunk.data(), chunk.size());
+  }
+
+  return true;
+}
+
+bool h5_read_compression_attributes(h5_file const& file, char const* varname, h5_compression& compression)
+{
+  if (h5_check_attribute(file, varname, "compression")) {
+    std::string name;
+    h5_read_attribute_string(file, varname, "compression", name);
+    if (!h5_parse_compression(name, compression.filter)) {
+      return false;
+    }
+  }
+
+  if (h5_check_attribute(file, varname, "compression_level")) {
+    cl_int level;
+    h5_read_attribute<cl_int>(file, varname, "compression_level", &level);
+    compression.level = level;
+    compression.level_given = true;
+  }
+
+  if (h5_check_attribute(file, varname, "chunk")) {
+    std::vector<cl_ulong> chunk(h5_get_attribute_size(file, varname, "chunk"));
+    h5_read_attribute<cl_ulong>(file, varname, "chunk", chunk.data());
+    compression.chunk.assign(chunk.begin(), chunk.end());
+  }
+
+  if (compression.filter != h5_compression::scaleoffset) {
+    return true;
+  }
+
+  hid_t dataset = H5Dopen(file.id(), varname, H5P_DEFAULT);
+  if (dataset < 0) {
+    return true;
+  }
+  hid_t datatype = H5Dget_type(dataset);
+  bool is_float = H5Tget_class(datatype) == H5T_FLOAT;
+  H5Tclose(datatype);
+  H5Dclose(dataset);
+
+  if (is_float && !compression.level_given) {
+    std::cerr << ERROR_INFO << "The scale-offset filter of '" << varname << "' is lossy for floating point data and requires "
+              << "the number of decimal digits to keep as `Compression_Level` or attribute `compression_level`." << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool h5_write_compression_attributes(h5_file const& file, char const* varname, h5_compression const& compression)
+{
+  h5_write_attribute_string(file, varname, "compression", h5_compression_name(compression.filter));
+  h5_write_attribute<cl_int>(file, varname, "compression_level", &compression.level, 1);
+
+  if (!compression.chunk.empty()) {
+    std::vector<cl_ulong> chunk(compression.chunk.begin(), compression.chunk.end());
+    h5_write_attribute<cl_ulong>(file, varname, "chunk", chunk.data(), chunk.size());
+  }
+
+  return true;
+}
+
 
 // read a single item from an HDF5 file
 // template<typename TYPE>
@@ -325,48 +841,39 @@ template bool h5_write_buffer(char const* filename, char const* varname, cl_ulon
 
 // write a single item to an HDF5 file
 template<typename TYPE>
-bool h5_write_single(char const* filename, char const* varname, TYPE data)
+bool h5_write_single(h5_file const& file, char const* varname, TYPE data)
 {
-  hid_t h5_file_id;
-
-  if (!fileExists(filename)) {
-    h5_file_id = H5Fcreate(filename, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
-  }
-  else {
-    h5_file_id = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT);
+  if (!file.is_open()) {
+    return false;
   }
 
-  H5LTmake_dataset(h5_file_id, varname, 0, NULL, type_to_h5_type<TYPE>(), &data);
-
-  H5Fclose(h5_file_id);
+  H5LTmake_dataset(file.id(), varname, 0, NULL, type_to_h5_type<TYPE>(), &data);
 
   return true;
 }
 
 // template instantiations
-template bool h5_write_single(char const* filename, char const* varname, float data);
-template bool h5_write_single(char const* filename, char const* varname, double data);
-template bool h5_write_single(char const* filename, char const* varname, cl_char data);
-template bool h5_write_single(char const* filename, char const* varname, cl_uchar data);
-template bool h5_write_single(char const* filename, char const* varname, cl_short data);
-template bool h5_write_single(char const* filename, char const* varname, cl_ushort data);
-template bool h5_write_single(char const* filename, char const* varname, cl_int data);
-template bool h5_write_single(char const* filename, char const* varname, cl_uint data);
-template bool h5_write_single(char const* filename, char const* varname, cl_long data);
-template bool h5_write_single(char const* filename, char const* varname, cl_ulong data);
+template bool h5_write_single(h5_file const& file, char const* varname, float data);
+template bool h5_write_single(h5_file const& file, char const* varname, double data);
+template bool h5_write_single(h5_file const& file, char const* varname, cl_char data);
+template bool h5_write_single(h5_file const& file, char const* varname, cl_uchar data);
+template bool h5_write_single(h5_file const& file, char const* varname, cl_short data);
+template bool h5_write_single(h5_file const& file, char const* varname, cl_ushort data);
+template bool h5_write_single(h5_file const& file, char const* varname, cl_int data);
+template bool h5_write_single(h5_file const& file, char const* varname, cl_uint data);
+template bool h5_write_single(h5_file const& file, char const* varname, cl_long data);
+template bool h5_write_single(h5_file const& file, char const* varname, cl_ulong data);
 
 
 // reading and writing single strings
-bool h5_read_string(char const* filename, char const* varname, std::string& output)
+bool h5_read_string(h5_file const& file, char const* varname, std::string& output)
 {
-  if (!fileExists(filename)) {
-    std::cerr << ERROR_INFO << "File '" << filename << "' not found." << std::endl;
+  if (!file.is_open()) {
     //TODO: File not found - no idea what error code to use
     return false;
   }
 
-  hid_t h5_file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
-  hid_t dataset = H5Dopen(h5_file_id, varname, H5P_DEFAULT);
+  hid_t dataset = H5Dopen(file.id(), varname, H5P_DEFAULT);
 
   hid_t datatype = H5Dget_type(dataset);
   bool variable_length = H5Tis_variable_str(datatype);
@@ -397,41 +904,175 @@ bool h5_read_string(char const* filename, char const* varname, std::string& outp
   H5Sclose(dataspace);
   H5Tclose(datatype);
   H5Dclose(dataset);
-  H5Fclose(h5_file_id);
 
   return true;
 }
 
+bool h5_write_string(h5_file const& file, char const* varname, std::string const& buffer)
+{
+  if (!file.is_open()) {
+    return false;
+  }
+
+  H5LTmake_dataset_string(file.id(), varname, buffer.c_str());
+
+  return true;
+}
+
+bool h5_read_string(char const* filename, char const* varname, std::string& output)
+{
+  h5_file file(filename, h5_file::read_only);
+  return h5_read_string(file, varname, output);
+}
+
 bool h5_write_string(char const* filename, char const* varname, std::string const& buffer)
 {
-  hid_t h5_file_id;
+  h5_file file(filename, h5_file::read_write);
+  return h5_write_string(file, varname, buffer);
+}
 
-  if (!fileExists(filename)) {
-    h5_file_id = H5Fcreate(filename, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+// attributes
+bool h5_check_attribute(h5_file const& file, char const* objname, char const* attrname)
+{
+  if (!file.is_open() || H5LTpath_valid(file.id(), objname, true) <= 0) {
+    return false;
   }
-  else {
-    h5_file_id = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT);
+
+  return H5Aexists_by_name(file.id(), objname, attrname, H5P_DEFAULT) > 0;
+}
+
+size_t h5_get_attribute_size(h5_file const& file, char const* objname, char const* attrname)
+{
+  if (!h5_check_attribute(file, objname, attrname)) {
+    return 0;
+  }
+
+  hid_t attribute = H5Aopen_by_name(file.id(), objname, attrname, H5P_DEFAULT, H5P_DEFAULT);
+  hid_t dataspace = H5Aget_space(attribute);
+  hssize_t npoints = H5Sget_simple_extent_npoints(dataspace);
+  H5Sclose(dataspace);
+  H5Aclose(attribute);
+
+  return npoints;
+}
+
+template<typename TYPE>
+bool h5_read_attribute(h5_file const& file, char const* objname, char const* attrname, TYPE* data)
+{
+  if (!h5_check_attribute(file, objname, attrname)) {
+    std::cerr << ERROR_INFO << "Attribute '" << attrname << "' of '" << objname << "' not found in file '" << file.name() << "'." << std::endl;
+    return false;
+  }
+
+  hid_t attribute = H5Aopen_by_name(file.id(), objname, attrname, H5P_DEFAULT, H5P_DEFAULT);
+  herr_t err = H5Aread(attribute, type_to_h5_type<TYPE>(), data);
+  H5Aclose(attribute);
+
+  return err >= 0;
+}
+
+// template instantiations
+template bool h5_read_attribute(h5_file const& file, char const* objname, char const* attrname, float* data);
+template bool h5_read_attribute(h5_file const& file, char const* objname, char const* attrname, double* data);
+template bool h5_read_attribute(h5_file const& file, char const* objname, char const* attrname, cl_char* data);
+template bool h5_read_attribute(h5_file const& file, char const* objname, char const* attrname, cl_uchar* data);
+template bool h5_read_attribute(h5_file const& file, char const* objname, char const* attrname, cl_short* data);
+template bool h5_read_attribute(h5_file const& file, char const* objname, char const* attrname, cl_ushort* data);
+template bool h5_read_attribute(h5_file const& file, char const* objname, char const* attrname, cl_int* data);
+template bool h5_read_attribute(h5_file const& file, char const* objname, char const* attrname, cl_uint* data);
+template bool h5_read_attribute(h5_file const& file, char const* objname, char const* attrname, cl_long* data);
+template bool h5_read_attribute(h5_file const& file, char const* objname, char const* attrname, cl_ulong* data);
+
+template<typename TYPE>
+bool h5_write_attribute(h5_file const& file, char const* objname, char const* attrname, TYPE const* data, size_t size)
+{
+  if (!file.is_open()) {
+    return false;
+  }
+
+  if (H5Aexists_by_name(file.id(), objname, attrname, H5P_DEFAULT) > 0) {
+    H5Adelete_by_name(file.id(), objname, attrname, H5P_DEFAULT);
+  }
+
+  hsize_t hdf_dims[1] = {size};
+  hid_t dataspace = H5Screate_simple(1, hdf_dims, NULL);
+  hid_t attribute = H5Acreate_by_name(file.id(), objname, attrname, type_to_h5_type<TYPE>(), dataspace,
+                                      H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  herr_t err = H5Awrite(attribute, type_to_h5_type<TYPE>(), data);
+  H5Aclose(attribute);
+  H5Sclose(dataspace);
+
+  return err >= 0;
+}
+
+// template instantiations
+template bool h5_write_attribute(h5_file const& file, char const* objname, char const* attrname, float const* data, size_t size);
+template bool h5_write_attribute(h5_file const& file, char const* objname, char const* attrname, double const* data, size_t size);
+template bool h5_write_attribute(h5_file const& file, char const* objname, char const* attrname, cl_char const* data, size_t size);
+template bool h5_write_attribute(h5_file const& file, char const* objname, char const* attrname, cl_uchar const* data, size_t size);
+template bool h5_write_attribute(h5_file const& file, char const* objname, char const* attrname, cl_short const* data, size_t size);
+template bool h5_write_attribute(h5_file const& file, char const* objname, char const* attrname, cl_ushort const* data, size_t size);
+template bool h5_write_attribute(h5_file const& file, char const* objname, char const* attrname, cl_int const* data, size_t size);
+template bool h5_write_attribute(h5_file const& file, char const* objname, char const* attrname, cl_uint const* data, size_t size);
+template bool h5_write_attribute(h5_file const& file, char const* objname, char const* attrname, cl_long const* data, size_t size);
+template bool h5_write_attribute(h5_file const& file, char const* objname, char const* attrname, cl_ulong const* data, size_t size);
+
+bool h5_read_attribute_string(h5_file const& file, char const* objname, char const* attrname, std::string& output)
+{
+  if (!h5_check_attribute(file, objname, attrname)) {
+    std::cerr << ERROR_INFO << "Attribute '" << attrname << "' of '" << objname << "' not found in file '" << file.name() << "'." << std::endl;
+    return false;
   }
 
-  H5LTmake_dataset_string(h5_file_id, varname, buffer.c_str());
+  hid_t attribute = H5Aopen_by_name(file.id(), objname, attrname, H5P_DEFAULT, H5P_DEFAULT);
+  hid_t datatype = H5Aget_type(attribute);
+
+  // only the first string is used for arrays of strings
+  hid_t dataspace = H5Aget_space(attribute);
+  hssize_t npoints = H5Sget_simple_extent_npoints(dataspace);
+
+  if (H5Tis_variable_str(datatype) > 0) {
+    std::vector<char*> buffer(npoints, nullptr);
+    hid_t memtype = H5Tcopy(H5T_C_S1);
+    H5Tset_size(memtype, H5T_VARIABLE);
+    H5Aread(attribute, memtype, &(buffer[0]));
+    output = std::string(buffer.at(0) == nullptr ? "" : buffer.at(0));
+    H5Dvlen_reclaim(memtype, dataspace, H5P_DEFAULT, &(buffer[0]));
+    H5Tclose(memtype);
+  }
+  else {
+    std::vector<char> buffer(H5Tget_size(datatype) * npoints + 1, '\0');
+    H5Aread(attribute, datatype, &(buffer[0]));
+    output = std::string(&(buffer[0]));
+  }
 
-  H5Fclose(h5_file_id);
+  H5Sclose(dataspace);
+  H5Tclose(datatype);
+  H5Aclose(attribute);
 
   return true;
 }
 
+bool h5_write_attribute_string(h5_file const& file, char const* objname, char const* attrname, std::string const& value)
+{
+  if (!file.is_open()) {
+    return false;
+  }
+
+  return H5LTset_attribute_string(file.id(), objname, attrname, value.c_str()) >= 0;
+}
+
 
 // reading and writing arrays of strings
-bool h5_read_strings(char const* filename, char const* varname, std::vector<std::string>& lines)
+bool h5_read_strings(h5_file const& file, char const* varname, std::vector<std::string>& lines)
 {
-  if (!fileExists(filename)) {
-    std::cerr << ERROR_INFO << "File '" << filename << "' not found." << std::endl;
+  if (!file.is_open()) {
     //TODO: File not found - Exception? Error code?
     return false;
   }
 
-  hid_t h5_file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
-  hid_t dataset = H5Dopen(h5_file_id, varname, H5P_DEFAULT);
+  hid_t dataset = H5Dopen(file.id(), varname, H5P_DEFAULT);
 
   hid_t datatype = H5Dget_type(dataset);
   bool variable_length = H5Tis_variable_str(datatype);
@@ -461,7 +1102,7 @@ bool h5_read_strings(char const* filename, char const* varname, std::vector<std:
     hssize_t num_lines = H5Sget_simple_extent_npoints(dataspace);
 
     std::vector<char> buffer(line_length * num_lines, '\0');
-    H5LTread_dataset_string(h5_file_id, varname, &(buffer[0]));
+    H5LTread_dataset_string(file.id(), varname, &(buffer[0]));
 
     size_t str_start = 0;
     for (hssize_t lines_found = 0; lines_found < num_lines; ++lines_found) {
@@ -473,13 +1114,16 @@ bool h5_read_strings(char const* filename, char const* varname, std::vector<std:
   H5Sclose(dataspace);
   H5Tclose(datatype);
   H5Dclose(dataset);
-  H5Fclose(h5_file_id);
 
   return true;
 }
 
-bool h5_write_strings(char const* filename, char const* varname, std::vector<std::string> const& lines)
+bool h5_write_strings(h5_file const& file, char const* varname, std::vector<std::string> const& lines)
 {
+  if (!file.is_open()) {
+    return false;
+  }
+
   // create single C string using the format of the (deprecated) matlab function
   // `hdf5write` for cell arrays of char arrays (aka strings)
   size_t line_length = std::max_element(
@@ -493,18 +1137,10 @@ bool h5_write_strings(char const* filename, char const* varname, std::vector<std
   }
 
   // save buffer and additional information
-  hid_t h5_file_id;
-  if (!fileExists(filename)) {
-    h5_file_id = H5Fcreate(filename, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
-  }
-  else {
-    h5_file_id = H5Fopen(filename, H5F_ACC_RDWR , H5P_DEFAULT);
-  }
-
   hsize_t hdf_dims[1] = {lines.size()};
   hid_t dataspace = H5Screate_simple(1, hdf_dims, NULL);
   hid_t datatype = H5Tcreate(H5T_STRING, line_length);
-  hid_t dataset = H5Dcreate2(h5_file_id, varname, datatype, dataspace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  hid_t dataset = H5Dcreate2(file.id(), varname, datatype, dataspace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 
   H5Dwrite(dataset, datatype, dataspace, dataspace, H5P_DEFAULT, &(buffer[0]));
 
@@ -512,7 +1148,73 @@ bool h5_write_strings(char const* filename, char const* varname, std::vector<std
   H5Tclose(datatype);
   H5Sclose(dataspace);
 
-  H5Fclose(h5_file_id);
-
   return true;
 }
+
+bool h5_read_strings(char const* filename, char const* varname, std::vector<std::string>& lines)
+{
+  h5_file file(filename, h5_file::read_only);
+  return h5_read_strings(file, varname, lines);
+}
+
+bool h5_write_strings(char const* filename, char const* varname, std::vector<std::string> const& lines)
+{
+  h5_file file(filename, h5_file::read_write);
+  return h5_write_strings(file, varname, lines);
+}
+
+
+// The name is stored as fixed-length string of the longest name. Each duration is followed by
+// its bandwidth (bytes per ns, i.e. GB/s).
+bool h5_write_transfer_table(h5_file const& file, char const* varname, std::vector<h5_transfer_record> const& records)
+{
+  if (!file.is_open() || records.empty()) {
+    return false;
+  }
+
+  size_t name_length = std::max_element(records.cbegin(), records.cend(),
+    [] (h5_transfer_record const& r1, h5_transfer_record const& r2) { return r1.name.size() < r2.name.size(); } )->name.size() + 1;
+
+  constexpr hsize_t num_fields = 10;
+  char const* field_names[num_fields] = {"Name", "Bytes", "HDF5_Read", "HDF5_Read_GBs", "Upload", "Upload_GBs",
+                                         "Readback", "Readback_GBs", "HDF5_Write", "HDF5_Write_GBs"};
+  size_t field_offsets[num_fields];
+  size_t field_sizes[num_fields];
+  hid_t field_types[num_fields];
+
+  hid_t name_type = H5Tcopy(H5T_C_S1);
+  H5Tset_size(name_type, name_length);
+  field_types[0] = name_type;
+  field_types[1] = type_to_h5_type<cl_ulong>();
+  field_offsets[0] = 0;
+  field_sizes[0] = name_length;
+  field_offsets[1] = name_length;
+  field_sizes[1] = sizeof(cl_ulong);
+  for (hsize_t field = 2; field < num_fields; ++field) {
+    field_types[field] = type_to_h5_type<double>();
+    field_offsets[field] = field_offsets[field - 1] + field_sizes[field - 1];
+    field_sizes[field] = sizeof(double);
+  }
+  size_t record_size = field_offsets[num_fields - 1] + field_sizes[num_fields - 1];
+
+  std::vector<char> buffer(record_size * records.size(), '\0');
+  for (size_t idx = 0; idx < records.size(); ++idx) {
+    h5_transfer_record const& record = records.at(idx);
+    char* row = &(buffer[idx * record_size]);
+    strncpy(row, record.name.c_str(), name_length - 1);
+    memcpy(row + field_offsets[1], &record.bytes, sizeof(cl_ulong));
+
+    double times[4] = {record.read_time, record.upload_time, record.download_time, record.write_time};
+    for (int step = 0; step < 4; ++step) {
+      double bandwidth = times[step] > 0.0 ? record.bytes / (times[step] * 1.0e6) : 0.0;
+      memcpy(row + field_offsets[2 + 2 * step], &times[step], sizeof(double));
+      memcpy(row + field_offsets[3 + 2 * step], &bandwidth, sizeof(double));
+    }
+  }
+
+  herr_t err = H5TBmake_table("Transfers per dataset", file.id(), varname, num_fields, records.size(), record_size,
+                              field_names, field_offsets, field_types, std::min<hsize_t>(records.size(), 64), NULL, 0, buffer.data());
+  H5Tclose(name_type);
+
+  return err >= 0;
+}
@@ -4,7 +4,10 @@
 #include <chrono>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <map>
 #include <math.h>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <thread>
@@ -15,6 +18,10 @@
 #include "util.hpp"
 #include "hdf5_io.hpp"
 #include "ocl_dev_mgr.hpp"
+#include "exec_plan.hpp"
+#include "tiling.hpp"
+#include "multi_device.hpp"
+#include "trace.hpp"
 #include "timer.hpp"
 
 
@@ -210,13 +217,180 @@ bool cmdOptionExists(char** begin, char** end, const std::string& option)
   return find(begin, end, option) != end;
 }
 
+// access of a dataset by the kernels, given by the attribute `access`:
+// 0 = read_write (default), 1 = read_only, 2 = write_only
+bool get_access_flag(h5_file const& config_file, std::string const& varname, cl_int& flag)
+{
+  flag = 0;
+  if (!h5_check_attribute(config_file, varname.c_str(), "access")) {
+    return true;
+  }
+
+  std::string access;
+  h5_read_attribute_string(config_file, varname.c_str(), "access", access);
+
+  if (access == "read_write") {
+    flag = 0;
+  }
+  else if (access == "read_only") {
+    flag = 1;
+  }
+  else if (access == "write_only") {
+    flag = 2;
+  }
+  else {
+    cerr << ERROR_INFO << "Unknown access mode '" << access << "' of '" << varname << "'." << endl;
+    return false;
+  }
+
+  return true;
+}
+
+// kernel argument indices of the datasets `names`: datasets with an attribute `arg_index` are
+// bound at that index, the remaining ones fill the free indices in the given order
+bool get_arg_indices(h5_file const& config_file, std::vector<std::string> const& names, std::vector<cl_uint>& arg_indices)
+{
+  std::vector<cl_int> explicit_indices(names.size(), -1);
+  std::vector<bool> used(names.size(), false);
+
+  for (size_t i = 0; i < names.size(); i++) {
+    if (!h5_check_attribute(config_file, names.at(i).c_str(), "arg_index")) {
+      continue;
+    }
+
+    h5_read_attribute<cl_int>(config_file, names.at(i).c_str(), "arg_index", &explicit_indices.at(i));
+    cl_int idx = explicit_indices.at(i);
+    if (idx < 0 || idx >= (cl_int)names.size() || used.at(idx)) {
+      cerr << ERROR_INFO << "Invalid or duplicate arg_index " << idx << " of '" << names.at(i) << "'." << endl;
+      return false;
+    }
+    used.at(idx) = true;
+  }
+
+  arg_indices.resize(names.size());
+  cl_uint next_idx = 0;
+  for (size_t i = 0; i < names.size(); i++) {
+    if (explicit_indices.at(i) >= 0) {
+      arg_indices.at(i) = explicit_indices.at(i);
+      continue;
+    }
+
+    while (used.at(next_idx)) {
+      ++next_idx;
+    }
+    arg_indices.at(i) = next_idx++;
+  }
+
+  return true;
+}
+
+// ranges of the kernel launches; datasets of other integer types are converted by HDF5
+struct kernel_ranges {
+  cl_ulong range_start[3] = {0, 0, 0};
+  cl_ulong global_range[3] = {0, 0, 0};
+  cl_ulong local_range[3] = {0, 0, 0}; // all zero: chosen by the OpenCL implementation
+};
+
+// read the ranges in the group `group`; missing ranges keep their value
+void read_ranges(h5_file const& config_file, std::string const& group, kernel_ranges& ranges)
+{
+  if (h5_check_object(config_file, (group + "Range_Start").c_str())) {
+    h5_read_buffer<cl_ulong>(config_file, (group + "Range_Start").c_str(), ranges.range_start);
+  }
+  if (h5_check_object(config_file, (group + "Global_Range").c_str())) {
+    h5_read_buffer<cl_ulong>(config_file, (group + "Global_Range").c_str(), ranges.global_range);
+  }
+  if (h5_check_object(config_file, (group + "Local_Range").c_str())) {
+    h5_read_buffer<cl_ulong>(config_file, (group + "Local_Range").c_str(), ranges.local_range);
+  }
+}
+
+void write_ranges(h5_file const& out_file, std::string const& group, kernel_ranges const& ranges)
+{
+  h5_write_buffer<cl_ulong>(out_file, (group + "Range_Start").c_str(), ranges.range_start, 3);
+  h5_write_buffer<cl_ulong>(out_file, (group + "Global_Range").c_str(), ranges.global_range, 3);
+  h5_write_buffer<cl_ulong>(out_file, (group + "Local_Range").c_str(), ranges.local_range, 3);
+}
+
+// distribution of the launch durations (in ms) of a kernel; the percentiles are nearest-rank
+void write_timing(h5_file const& out_file, std::string const& group, std::vector<double> const& durations)
+{
+  if (durations.empty()) {
+    return;
+  }
+
+  std::vector<double> sorted(durations);
+  std::sort(sorted.begin(), sorted.end());
+  size_t n = sorted.size();
+
+  auto percentile = [&](double p) {
+    size_t rank = (size_t)ceil(p / 100.0 * n);
+    return sorted.at(std::max<size_t>(rank, 1) - 1);
+  };
+
+  double mean = 0.0;
+  for (double duration : sorted) {
+    mean += duration;
+  }
+  mean /= n;
+  double median = (n % 2 == 1) ? sorted.at(n / 2) : 0.5 * (sorted.at(n / 2 - 1) + sorted.at(n / 2));
+
+  h5_create_dir(out_file, group.c_str());
+  h5_write_buffer<double>(out_file, (group + "/Durations").c_str(), durations.data(), n);
+  h5_write_single<double>(out_file, (group + "/Min").c_str(), sorted.front());
+  h5_write_single<double>(out_file, (group + "/Median").c_str(), median);
+  h5_write_single<double>(out_file, (group + "/Mean").c_str(), mean);
+  h5_write_single<double>(out_file, (group + "/P95").c_str(), percentile(95.0));
+  h5_write_single<double>(out_file, (group + "/P99").c_str(), percentile(99.0));
+  h5_write_single<double>(out_file, (group + "/Max").c_str(), sorted.back());
+}
+
+// Profiling timestamps (ns) of a series of commands and their phases (ms): Queue_Latency from
+// QUEUED to START covers the runtime and the device queue, Device_Time from START to END the
+// execution on the device only.
+void write_profiles(h5_file const& out_file, std::string const& group, std::vector<ocl_dev_mgr::profiling_info> const& profiles)
+{
+  if (profiles.empty()) {
+    return;
+  }
+
+  size_t n = profiles.size();
+  std::vector<cl_ulong> timestamps(n);
+  std::vector<double> queue_latency(n);
+  std::vector<double> device_time(n);
+  for (size_t idx = 0; idx < n; idx++) {
+    queue_latency.at(idx) = (profiles.at(idx).start - profiles.at(idx).queued) / 1.0e6;
+    device_time.at(idx) = (profiles.at(idx).end - profiles.at(idx).start) / 1.0e6;
+  }
+
+  if (!h5_check_object(out_file, group.c_str())) {
+    h5_create_dir(out_file, group.c_str());
+  }
+  for (size_t idx = 0; idx < n; idx++) timestamps.at(idx) = profiles.at(idx).queued;
+  h5_write_buffer<cl_ulong>(out_file, (group + "/Queued").c_str(), timestamps.data(), n);
+  for (size_t idx = 0; idx < n; idx++) timestamps.at(idx) = profiles.at(idx).submit;
+  h5_write_buffer<cl_ulong>(out_file, (group + "/Submit").c_str(), timestamps.data(), n);
+  for (size_t idx = 0; idx < n; idx++) timestamps.at(idx) = profiles.at(idx).start;
+  h5_write_buffer<cl_ulong>(out_file, (group + "/Start").c_str(), timestamps.data(), n);
+  for (size_t idx = 0; idx < n; idx++) timestamps.at(idx) = profiles.at(idx).end;
+  h5_write_buffer<cl_ulong>(out_file, (group + "/End").c_str(), timestamps.data(), n);
+  h5_write_buffer<double>(out_file, (group + "/Queue_Latency").c_str(), queue_latency.data(), n);
+  h5_write_buffer<double>(out_file, (group + "/Device_Time").c_str(), device_time.data(), n);
+}
+
 void print_help()
 {
   cout << "Usage: toolkitICL [options] -c config.h5" << endl
        << "Options:" << endl
        << "  -d device_id: " << "Use the device specified by `device_id`." << endl
+       << "  -d id,id,...: " << "Split the range between the given devices (`-d all`: all available devices)." << endl
+       << "  -numa       : " << "Split a CPU device into one sub-device per NUMA node and split the range between them." << endl
        << "  -b          : " << "Activate the benchmark mode (additional delay before & after runs)." << endl
+       << "  -a          : " << "Activate the asynchronous mode (enqueue all kernels without waiting for each launch)." << endl
        << "  -c config.h5: " << "Specify the URL `config.h5` of the HDF5 configuration file." << endl
+       << "  -pc cache_dir: " << "Use `cache_dir` as persistent cache of compiled program binaries." << endl
+       << "  -ct threads : " << "Use `threads` threads to compress the output data (default: all hardware threads)." << endl
+       << "  -trace file : " << "Write the timeline of the host stages and device commands to `file` (Chrome trace format)." << endl
 #if defined(USENVML)
        << "  -np sample_rate: " << "Log Nvidia GPU power consumption with sample_rate (ms)" << endl
        << "  -nt sample_rate: " << "Log Nvidia GPU temperature with sample_rate (ms)" << endl
@@ -238,9 +412,10 @@ int main(int argc, char *argv[]) {
     cout << "Benchmark mode" << endl << endl;
   }
 
-  if (cmdOptionExists(argv, argv + argc, "-d")) {
-    char const* dev_id = getCmdOption(argv, argv + argc, "-d");
-    deviceIndex = atoi(dev_id);
+  bool async_mode = false;
+  if (cmdOptionExists(argv, argv + argc, "-a"))  {
+    async_mode = true;
+    cout << "Asynchronous mode" << endl << endl;
   }
 
   if (cmdOptionExists(argv, argv + argc, "-h") || !cmdOptionExists(argv, argv + argc, "-c")) {
@@ -249,6 +424,22 @@ int main(int argc, char *argv[]) {
   }
   char const* filename = getCmdOption(argv, argv + argc, "-c");
 
+  string cache_dir;
+  if (cmdOptionExists(argv, argv + argc, "-pc") && getCmdOption(argv, argv + argc, "-pc") != nullptr) {
+    cache_dir = string(getCmdOption(argv, argv + argc, "-pc"));
+    if (!createDir(cache_dir)) {
+      cerr << "Warning: Cannot create program cache directory '" << cache_dir << "'." << endl;
+      cache_dir.clear();
+    }
+  }
+
+  // `-trace trace.json` writes the timeline of the run in the Chrome trace event format
+  string trace_filename;
+  if (cmdOptionExists(argv, argv + argc, "-trace") && getCmdOption(argv, argv + argc, "-trace") != nullptr) {
+    trace_filename = string(getCmdOption(argv, argv + argc, "-trace"));
+  }
+  trace_writer trace(timer);
+
 #if defined(USENVML)
   if (cmdOptionExists(argv, argv + argc, "-np")) {
     char const* tmp = getCmdOption(argv, argv + argc, "-np");
@@ -262,25 +453,101 @@ int main(int argc, char *argv[]) {
      nv_log_tmp = true;
   }
 #endif
+
+  // wall-clock durations of the consecutive host phases in ms, written to `/Host_Timing` and
+  // added as host stages to the trace
+  std::vector<std::pair<std::string, double>> host_phases;
+  auto end_phase = [&](std::string const& name, std::string const& trace_name, cl_ulong begin) {
+    cl_ulong end = trace.now();
+    host_phases.push_back(std::make_pair(name, (end - begin) / 1.0e6));
+    trace.add_host_stage(trace_name, "host", begin, end);
+    return end;
+  };
+
+  cl_ulong stage_begin = trace.now();
   ocl_dev_mgr& dev_mgr = ocl_dev_mgr::getInstance();
   cl_uint devices_availble=dev_mgr.get_avail_dev_num();
+  stage_begin = end_phase("Device_Enumeration", "Device enumeration", stage_begin);
+
+  // `-d 0,2` or `-d all` selects several devices; context i belongs to device_indices[i]. A device
+  // may be given more than once, e.g. to test the multi-device mode on a single device.
+  std::vector<cl_uint> device_indices;
+  string dev_ids = "0";
+  if (cmdOptionExists(argv, argv + argc, "-d") && getCmdOption(argv, argv + argc, "-d") != nullptr) {
+    dev_ids = string(getCmdOption(argv, argv + argc, "-d"));
+  }
+  if (dev_ids == "all") {
+    for (cl_uint i = 0; i < devices_availble; i++) {
+      device_indices.push_back(i);
+    }
+  }
+  else {
+    stringstream dev_stream(dev_ids);
+    string dev_id;
+    while (getline(dev_stream, dev_id, ',')) {
+      device_indices.push_back(atoi(dev_id.c_str()));
+    }
+  }
+  if (device_indices.empty()) {
+    cerr << ERROR_INFO << "No OpenCL device selected." << endl;
+    return -1;
+  }
+  for (cl_uint idx : device_indices) {
+    if (idx >= devices_availble) {
+      cerr << ERROR_INFO << "Invalid device " << idx << " (available devices: " << devices_availble << ")." << endl;
+      return -1;
+    }
+  }
+  deviceIndex = device_indices.at(0);
+
+  cout << "Available devices: " << devices_availble << endl;
+  for (cl_uint idx : device_indices) {
+    cout << dev_mgr.get_avail_dev_info(idx).name.c_str() << endl;
+    cout << "OpenCL version: " << dev_mgr.get_avail_dev_info(idx).ocl_version.c_str() << endl;
+    cout << "Memory limit: "<< dev_mgr.get_avail_dev_info(idx).max_mem << endl;
+    cout << "WG limit: "<< dev_mgr.get_avail_dev_info(idx).wg_size << endl << endl;
+  }
 
-  cout << "Available devices: " << devices_availble << endl
-       << dev_mgr.get_avail_dev_info(deviceIndex).name.c_str() << endl;
-  cout << "OpenCL version: " << dev_mgr.get_avail_dev_info(deviceIndex).ocl_version.c_str() << endl;
-  cout << "Memory limit: "<< dev_mgr.get_avail_dev_info(deviceIndex).max_mem << endl;
-  cout << "WG limit: "<< dev_mgr.get_avail_dev_info(deviceIndex).wg_size << endl << endl;
-  dev_mgr.init_device(deviceIndex);
+  // `-numa` partitions a CPU device into sub-devices per NUMA node, which are used like several
+  // devices with the buffers of each sub-device placed on its own node
+  bool numa_mode = false;
+  if (cmdOptionExists(argv, argv + argc, "-numa")) {
+    if (device_indices.size() != 1 || dev_mgr.get_avail_dev_info(deviceIndex).type != CL_DEVICE_TYPE_CPU) {
+      cerr << "Warning: -numa requires a single CPU device and is ignored." << endl;
+    }
+    else if (dev_mgr.init_sub_devices(deviceIndex) == 0) {
+      cerr << "Warning: The device cannot be partitioned by NUMA nodes." << endl;
+    }
+    else {
+      numa_mode = true;
+      cout << "NUMA nodes: " << dev_mgr.get_context_num() << endl << endl;
+    }
+  }
+  if (!numa_mode) {
+    for (cl_uint idx : device_indices) {
+      dev_mgr.init_device(idx);
+    }
+  }
+  stage_begin = end_phase("Device_Init", "Device init", stage_begin);
+
+  cl_uint num_contexts = dev_mgr.get_context_num();
+  bool multi_device = num_contexts > 1;
+
+  h5_file config_file(filename, h5_file::read_only);
+  if (!config_file.is_open()) {
+    return -1;
+  }
+  stage_begin = end_phase("Config_Open", "Config file open", stage_begin);
 
   string kernel_url;
-  if (h5_check_object(filename, "Kernel_URL") == true) {
-    h5_read_string(filename, "Kernel_URL", kernel_url);
+  if (h5_check_object(config_file, "Kernel_URL") == true) {
+    h5_read_string(config_file, "Kernel_URL", kernel_url);
     cout << "Reading kernel from file: " << kernel_url << "... " << endl;
   }
-  else if (h5_check_object(filename, "Kernel_Source") == true) {
+  else if (h5_check_object(config_file, "Kernel_Source") == true) {
     cout << "Reading kernel from HDF5 file... " << endl;
     std::vector<std::string> kernel_source;
-    h5_read_strings(filename, "Kernel_Source", kernel_source);
+    h5_read_strings(config_file, "Kernel_Source", kernel_source);
     ofstream tmp_clfile;
     tmp_clfile.open("tmp_kernel.cl");
     for (string const& kernel : kernel_source) {
@@ -296,27 +563,80 @@ int main(int argc, char *argv[]) {
   }
 
   std::vector<std::string> kernel_list;
-  h5_read_strings(filename, "Kernels", kernel_list);
+  h5_read_strings(config_file, "Kernels", kernel_list);
+
+  // compression policy of the output; can be overwritten per dataset using attributes
+  h5_compression compression;
+  if (!h5_read_compression(config_file, compression)) {
+    return -1;
+  }
+
+  compression.threads = std::max(1u, std::thread::hardware_concurrency());
+  if (cmdOptionExists(argv, argv + argc, "-ct") && getCmdOption(argv, argv + argc, "-ct") != nullptr) {
+    compression.threads = std::max(1, atoi(getCmdOption(argv, argv + argc, "-ct")));
+  }
 
   cl_ulong kernel_repetitions = 1;
-  if (h5_check_object(filename, "Kernel_Repetitions")) {
-    kernel_repetitions = h5_read_single<cl_ulong>(filename, "Kernel_Repetitions");
+  if (h5_check_object(config_file, "Kernel_Repetitions")) {
+    kernel_repetitions = h5_read_single<cl_ulong>(config_file, "Kernel_Repetitions");
   }
   if (kernel_repetitions <= 0) {
     cout << "Warning: Setting `kernel_repetitions = " << kernel_repetitions << "` implies that no kernels are executed." << endl;
   }
 
-  dev_mgr.add_program_url(0, "ocl_Kernel", kernel_url);
-
   string settings;
-  h5_read_string(filename, "Kernel_Settings", settings);
-
+  h5_read_string(config_file, "Kernel_Settings", settings);
+
+  // the argument names are required to bind the datasets by name (OpenCL >= 1.2)
+  string build_options = settings;
+  bool arg_info = true;
+  for (cl_uint idx : device_indices) {
+    string const& ocl_version = dev_mgr.get_avail_dev_info(idx).ocl_version;
+    arg_info = arg_info && ocl_version.find("OpenCL 1.0") == string::npos && ocl_version.find("OpenCL 1.1") == string::npos;
+  }
+  if (arg_info) {
+    build_options += " -cl-kernel-arg-info";
+  }
 
-  uint64_t num_kernels_found = 0;
-  num_kernels_found = dev_mgr.compile_kernel(0, "ocl_Kernel", settings);
-  if (num_kernels_found == 0) {
-    cerr << "Error: No valid kernels found" << endl;
-    return -1;
+  for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+    dev_mgr.add_program_url(context_idx, "ocl_Kernel", kernel_url);
+  }
+  stage_begin = end_phase("Kernel_Load", "Kernel source load", stage_begin);
+
+  // the program is built for each device; the cache is hit only if it is hit for all of them
+  bool cache_hit = !cache_dir.empty();
+  std::vector<double> compile_times;
+  std::vector<std::string> build_logs;
+  for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+    cl_ulong compile_begin = trace.now();
+    uint64_t num_kernels_found = 0;
+    if (cache_dir.empty()) {
+      num_kernels_found = dev_mgr.compile_kernel(context_idx, "ocl_Kernel", build_options);
+    }
+    else {
+      bool context_cache_hit = false;
+      num_kernels_found = dev_mgr.compile_kernel_cached(context_idx, "ocl_Kernel", build_options, cache_dir, context_cache_hit);
+      cout << "Program binary cache " << (context_cache_hit ? "hit" : "miss") << endl;
+      cache_hit = cache_hit && context_cache_hit;
+    }
+    compile_times.push_back((trace.now() - compile_begin) / 1.0e6);
+    build_logs.push_back(dev_mgr.get_build_log(context_idx, "ocl_Kernel"));
+    if (num_kernels_found == 0) {
+      cerr << "Error: No valid kernels found" << endl;
+      return -1;
+    }
+  }
+  stage_begin = end_phase("Compile", "Compile", stage_begin);
+
+  // the device clocks are compared to the host clock before and after the run
+  if (!trace_filename.empty()) {
+    for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+      trace.set_device_name(context_idx, dev_mgr.get_context_dev_info(context_idx, 0).name);
+      if (!trace.calibrate(dev_mgr, context_idx)) {
+        cerr << "Warning: The clock of device " << context_idx << " cannot be aligned to the host clock." << endl;
+      }
+    }
+    stage_begin = end_phase("Clock_Calibration", "Clock calibration", stage_begin);
   }
 
   std::vector<std::string> found_kernels;
@@ -339,146 +659,694 @@ int main(int argc, char *argv[]) {
   std::vector<std::string> data_names;
   std::vector<HD5_Type> data_types;
   std::vector<size_t> data_sizes;
-  h5_get_content(filename, "/Data/", data_names, data_types, data_sizes);
+  h5_get_content(config_file, "/Data/", data_names, data_types, data_sizes);
+
+  // the compression policy of each dataset is checked against its type before the execution
+  std::vector<h5_compression> data_compressions(data_names.size(), compression);
+  for (cl_uint i = 0; i < data_names.size(); i++) {
+    if (!h5_read_compression_attributes(config_file, data_names.at(i).c_str(), data_compressions.at(i))) {
+      return -1;
+    }
+    if (data_compressions.at(i).filter == h5_compression::scaleoffset && (data_types.at(i) == H5_float || data_types.at(i) == H5_double)) {
+      cout << "Scale-offset filter of '" << data_names.at(i).c_str() << "' keeps " << data_compressions.at(i).level << " decimal digits." << endl;
+    }
+  }
 
+  // scalars and vector scalars passed by value
+  std::vector<std::string> arg_names;
+  std::vector<HD5_Type> arg_types;
+  std::vector<size_t> arg_sizes;
+  if (h5_check_object(config_file, "/Args")) {
+    h5_get_content(config_file, "/Args/", arg_names, arg_types, arg_sizes);
+  }
+
+  // __local arguments given by their size in bytes
+  std::vector<std::string> local_names;
+  std::vector<HD5_Type> local_types;
+  std::vector<size_t> local_sizes;
+  if (h5_check_object(config_file, "/Local_Args")) {
+    h5_get_content(config_file, "/Local_Args/", local_names, local_types, local_sizes);
+  }
+  stage_begin = end_phase("Data_Discovery", "HDF5 content discovery", stage_begin);
+
+  // buffers are bound first, followed by the by-value and the __local arguments
+  std::vector<std::string> bound_names(data_names);
+  bound_names.insert(bound_names.end(), arg_names.begin(), arg_names.end());
+  bound_names.insert(bound_names.end(), local_names.begin(), local_names.end());
+  std::vector<cl_uint> arg_indices;
+  if (!get_arg_indices(config_file, bound_names, arg_indices)) {
+    return -1;
+  }
+
+  // The datasets are bound per scheduled kernel to the arguments of the same name, where the
+  // group is not part of the name (e.g. `/Data/values` -> `values`). If not all arguments of
+  // a kernel can be resolved by name, the positional binding given by `arg_indices` is used.
+  // Datasets which are not bound to any scheduled kernel are neither allocated nor transferred.
+  // The argument `tile_offset` is set to the first row in the buffers (see tiled mode below).
+  std::map<std::string, std::vector<cl_int>> kernel_bindings; // argument index of each dataset or -1
+  std::map<std::string, cl_int> tile_offset_args;             // argument index of `tile_offset` or -1
+  for (string const& kernel_name : kernel_list) {
+    if (kernel_bindings.count(kernel_name) > 0) {
+      continue;
+    }
+    if (find(found_kernels.begin(), found_kernels.end(), kernel_name) == found_kernels.end()) {
+      cerr << "Error: Kernel '" << kernel_name << "' not found." << endl;
+      return -1;
+    }
+
+    std::vector<std::string> kernel_arg_names;
+    cl_uint num_args = dev_mgr.get_kernel_arg_names(*dev_mgr.getKernelbyName(0, "ocl_Kernel", kernel_name), kernel_arg_names);
+
+    std::vector<cl_int> binding(bound_names.size(), -1);
+    cl_int tile_offset_idx = -1;
+    cl_uint num_resolved = 0;
+    for (cl_uint arg_idx = 0; arg_idx < kernel_arg_names.size(); arg_idx++) {
+      bool resolved = false;
+      for (size_t j = 0; j < bound_names.size(); j++) {
+        if (binding.at(j) < 0 && bound_names.at(j).substr(bound_names.at(j).find_last_of('/') + 1) == kernel_arg_names.at(arg_idx)) {
+          binding.at(j) = arg_idx;
+          resolved = true;
+          break;
+        }
+      }
+      if (!resolved && kernel_arg_names.at(arg_idx) == "tile_offset") {
+        tile_offset_idx = arg_idx;
+        resolved = true;
+      }
+      num_resolved += resolved;
+    }
+
+    if (num_resolved == num_args && kernel_arg_names.size() == num_args) {
+      cout << "Binding arguments of kernel '" << kernel_name << "' by name" << endl;
+    }
+    else {
+      cout << "Binding arguments of kernel '" << kernel_name << "' by position" << endl;
+      for (size_t j = 0; j < bound_names.size(); j++) {
+        binding.at(j) = (arg_indices.at(j) < num_args) ? (cl_int)arg_indices.at(j) : -1;
+      }
+      tile_offset_idx = -1;
+    }
+
+    kernel_bindings[kernel_name] = binding;
+    tile_offset_args[kernel_name] = tile_offset_idx;
+  }
+
+  // kernel arguments the bound dataset `j` is bound to in the context `context_idx`
+  typedef exec_plan::arg_target arg_target;
+  auto get_arg_targets = [&](cl_uint context_idx, size_t j) {
+    std::vector<arg_target> targets;
+    for (auto const& kernel_binding : kernel_bindings) {
+      if (kernel_binding.second.at(j) >= 0) {
+        targets.push_back(arg_target{dev_mgr.getKernelbyName(context_idx, "ocl_Kernel", kernel_binding.first),
+                                     (cl_uint)kernel_binding.second.at(j)});
+      }
+    }
+    return targets;
+  };
+
+  std::vector<std::vector<arg_target>> arg_targets(bound_names.size());
+  for (size_t j = 0; j < bound_names.size(); j++) {
+    arg_targets.at(j) = get_arg_targets(0, j);
+  }
+
+  // The tiled (out-of-core) mode is used if `Tile_Size` is given or if the bound datasets do not
+  // fit into the device memory. Otherwise, the whole datasets are in the buffers.
+  ocl_dev_mgr::ocl_device_info const& dev_info = dev_mgr.get_avail_dev_info(deviceIndex);
+  bool tiled_mode = h5_check_object(config_file, "Tile_Size");
+  for (cl_uint idx : device_indices) {
+    cl_ulong bound_data_size = 0;
+    bool exceeds_alloc = false;
+    for (cl_uint i = 0; i < data_names.size(); i++) {
+      if (!arg_targets.at(i).empty()) {
+        cl_ulong var_size = data_sizes.at(i) * h5_type_size(data_types.at(i));
+        bound_data_size += var_size;
+        exceeds_alloc = exceeds_alloc || var_size > dev_mgr.get_avail_dev_info(idx).max_mem_alloc;
+      }
+    }
+    tiled_mode = tiled_mode || exceeds_alloc || bound_data_size > dev_mgr.get_avail_dev_info(idx).max_mem;
+  }
+  if (tiled_mode && multi_device) {
+    cerr << ERROR_INFO << "The tiled mode is not supported with several devices; the datasets have to fit into each device." << endl;
+    return -1;
+  }
+
+  // The halo rows are read once per tile from the configuration file and never exchanged between
+  // the tiles, hence only a single launch per tile reads valid neighbours. This is checked also
+  // if the tiled mode is not used, since it is chosen automatically depending on the device.
+  cl_ulong halo = 0;
+  if (h5_check_object(config_file, "Tile_Halo")) {
+    halo = h5_read_single<cl_ulong>(config_file, "Tile_Halo");
+  }
+  if (halo > 0 && (kernel_repetitions > 1 || kernel_list.size() > 1)) {
+    cerr << ERROR_INFO << "Tile_Halo requires a single kernel and Kernel_Repetitions = 1, since the halo rows are not "
+         << "updated between the launches of a tile." << endl;
+    return -1;
+  }
+
+  try {
+    for (auto const& tile_offset_arg : tile_offset_args) {
+      for (cl_uint context_idx = 0; context_idx < num_contexts && tile_offset_arg.second >= 0; context_idx++) {
+        cl_ulong tile_offset = 0;
+        dev_mgr.getKernelbyName(context_idx, "ocl_Kernel", tile_offset_arg.first)->setArg(tile_offset_arg.second, tile_offset);
+      }
+    }
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+  }
+
+  stage_begin = end_phase("Setup", "Argument binding and setup", stage_begin);
   cout << "Creating output HDF5 file..." << endl;
   string out_name = "out_" + string(filename);
 
   if (fileExists(out_name)) {
-    remove(out_name.c_str());
     cout << "Old HDF5 data file found and deleted!" << endl;
   }
-  h5_write_string(out_name.c_str(), "Host_OS", getOS().c_str());
-
-  h5_write_string(out_name.c_str(), "Kernel_Settings", settings);
+  h5_file out_file(out_name, h5_file::truncate);
+  if (!out_file.is_open()) {
+    return -1;
+  }
+  h5_write_string(out_file, "Host_OS", getOS().c_str());
+  h5_create_dir(out_file, "/Data");
+
+  h5_write_string(out_file, "Kernel_Settings", settings);
+  h5_write_single<cl_uchar>(out_file, "Kernel_CacheHit", cache_hit);
+  h5_write_compression(out_file, compression);
+
+  // On devices with host unified memory (CPUs, integrated GPUs), the datasets are read into
+  // page-aligned host arrays, which are used by the buffers directly (CL_MEM_USE_HOST_PTR).
+  // Neither the upload nor the mapped readback copy any data.
+  bool zero_copy = !tiled_mode && !multi_device && dev_info.host_unified;
+  constexpr size_t page_size = 4096;
+  h5_write_single<cl_uchar>(out_file, "Zero_Copy", zero_copy);
+  if (zero_copy) {
+    cout << "Zero-copy mode (host unified memory)" << endl;
+  }
 
-  std::vector<cl::Buffer> data_in;
-  bool blocking = CL_TRUE;
+  // the host arrays have to outlive the buffers using them
+  std::vector<std::unique_ptr<char, aligned_deleter>> host_arrays(data_names.size());
+  std::vector<cl::Buffer> data_in(data_names.size());
 
-  //TODO: Implement functionality! Allow other integer types instead of cl_int?
+  // read_only buffers are never read back, write_only buffers are never uploaded
   vector<cl_int> data_rw_flags(data_names.size(), 0);
+  for (cl_uint i = 0; i < data_names.size(); i++) {
+    if (!get_access_flag(config_file, data_names.at(i), data_rw_flags.at(i))) {
+      return -1;
+    }
+  }
 
   uint64_t push_time, pull_time;
   push_time = timer.getTimeMicroseconds();
+  stage_begin = end_phase("Output_Create", "Output file creation", stage_begin);
+
+  // Uploads are issued on the copy queue (queue 1). The (cheap) write-invalidate maps of all
+  // buffers are enqueued first, such that the HDF5 read of dataset i+1 overlaps with the
+  // transfer of dataset i. Kernels on queue 0 only wait for the uploads of their own buffers.
+  std::vector<void*> upload_data(data_names.size(), nullptr);
+  std::vector<cl::Event> map_upload_events(data_names.size());
+  std::vector<cl::Event> upload_events(data_names.size());
+  // HDF5 read and write times per dataset in ns
+  std::vector<cl_ulong> read_times(data_names.size(), 0);
+  std::vector<cl_ulong> write_times(data_names.size(), 0);
 
   for(cl_uint i = 0; i < data_names.size(); i++) {
+    if (tiled_mode || multi_device || arg_targets.at(i).empty()) {
+      continue;
+    }
+
     try {
-      uint8_t *tmp_data = nullptr;
-      size_t var_size = 0;
-
-      switch (data_types.at(i)) {
-        case H5_float:
-          var_size = data_sizes.at(i)*sizeof(float);
-          tmp_data = new uint8_t[var_size];
-          h5_read_buffer<float>(filename, data_names.at(i).c_str(), (float*)tmp_data);
-          break;
-        case H5_double:
-          var_size = data_sizes.at(i)*sizeof(double);
-          tmp_data = new uint8_t[var_size];
-          h5_read_buffer<double>(filename, data_names.at(i).c_str(), (double*)tmp_data);
-          break;
-        case H5_char:
-          var_size=data_sizes.at(i)*sizeof(cl_char);
-          tmp_data = new uint8_t[var_size];
-          h5_read_buffer<cl_char>(filename, data_names.at(i).c_str(), (cl_char*)tmp_data);
-          break;
-        case H5_uchar:
-          var_size = data_sizes.at(i)*sizeof(cl_uchar);
-          tmp_data = new uint8_t[var_size];
-          h5_read_buffer<cl_uchar>(filename, data_names.at(i).c_str(), (cl_uchar*)tmp_data);
-          break;
-        case H5_short:
-          var_size=data_sizes.at(i)*sizeof(cl_short);
-          tmp_data = new uint8_t[var_size];
-          h5_read_buffer<cl_short>(filename, data_names.at(i).c_str(), (cl_short*)tmp_data);
-          break;
-        case H5_ushort:
-          var_size=data_sizes.at(i)*sizeof(cl_ushort);
-          tmp_data = new uint8_t[var_size];
-          h5_read_buffer<cl_ushort>(filename, data_names.at(i).c_str(), (cl_ushort*)tmp_data);
-          break;
-        case H5_int:
-          var_size=data_sizes.at(i)*sizeof(cl_int);
-          tmp_data = new uint8_t[var_size];
-          h5_read_buffer<cl_int>(filename, data_names.at(i).c_str(), (cl_int*)tmp_data);
-          break;
-        case H5_uint:
-          var_size=data_sizes.at(i)*sizeof(cl_uint);
-          tmp_data = new uint8_t[var_size];
-          h5_read_buffer<cl_uint>(filename, data_names.at(i).c_str(), (cl_uint*)tmp_data);
-          break;
-        case H5_long:
-          var_size=data_sizes.at(i)*sizeof(cl_long);
-          tmp_data = new uint8_t[var_size];
-          h5_read_buffer<cl_long>(filename, data_names.at(i).c_str(), (cl_long*)tmp_data);
-          break;
-        case H5_ulong:
-          var_size=data_sizes.at(i)*sizeof(cl_ulong);
-          tmp_data = new uint8_t[var_size];
-          h5_read_buffer<cl_ulong>(filename, data_names.at(i).c_str(), (cl_ulong*)tmp_data);
-          break;
-        default:
-          cerr << ERROR_INFO << "Data type '" << data_types.at(i) << "' unknown." << endl;
-          break;
-      }
+      size_t var_size = data_sizes.at(i) * h5_type_size(data_types.at(i));
 
+      cl_mem_flags flags = CL_MEM_READ_WRITE;
       switch (data_rw_flags.at(i)) {
-        case 0:
-          data_in.push_back(cl::Buffer(dev_mgr.get_context(0), CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, var_size));
-          dev_mgr.get_queue(0, 0).enqueueWriteBuffer(data_in.back(), blocking, 0, var_size, tmp_data);
-          break;
-        case 1:
-          data_in.push_back(cl::Buffer(dev_mgr.get_context(0), CL_MEM_READ_ONLY | CL_MEM_ALLOC_HOST_PTR, var_size));
-          dev_mgr.get_queue(0, 0).enqueueWriteBuffer(data_in.back(), blocking, 0, var_size, tmp_data);
-          break;
-        case 2:
-          data_in.push_back(cl::Buffer(dev_mgr.get_context(0), CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR, var_size));
-          break;
+        case 1: flags = CL_MEM_READ_ONLY; break;
+        case 2: flags = CL_MEM_WRITE_ONLY; break;
       }
 
-      for (uint32_t kernel_idx = 0; kernel_idx < found_kernels.size(); kernel_idx++) {
-        dev_mgr.getKernelbyName(0, "ocl_Kernel", found_kernels.at(kernel_idx))->setArg(i, data_in.back());
+      if (zero_copy) {
+        // the size is rounded up to whole pages, as required for zero-copy by some implementations
+        host_arrays.at(i).reset((char*)aligned_malloc(std::max<size_t>((var_size + page_size - 1) / page_size, 1) * page_size, page_size));
+        if (!host_arrays.at(i)) {
+          cerr << ERROR_INFO << "Cannot allocate " << var_size << " bytes for '" << data_names.at(i) << "'." << endl;
+          return -1;
+        }
+        if (data_rw_flags.at(i) != 2) {
+          cl_ulong read_begin = trace.now();
+          h5_read_buffer(config_file, data_names.at(i).c_str(), data_types.at(i), host_arrays.at(i).get());
+          cl_ulong read_end = trace.now();
+          read_times.at(i) = read_end - read_begin;
+          trace.add_host_stage("HDF5 read " + data_names.at(i), "hdf5", read_begin, read_end);
+        }
+        data_in.at(i) = cl::Buffer(dev_mgr.get_context(0), flags | CL_MEM_USE_HOST_PTR, var_size, host_arrays.at(i).get());
+      }
+      else {
+        // the buffer is created first and the data are read from the HDF5 file directly
+        // into the mapped (pinned) host memory, avoiding an additional staging copy
+        data_in.at(i) = cl::Buffer(dev_mgr.get_context(0), flags | CL_MEM_ALLOC_HOST_PTR, var_size);
       }
 
-      if (tmp_data != nullptr) {
-        delete[] tmp_data; tmp_data = nullptr;
+      if (!zero_copy && data_rw_flags.at(i) != 2) {
+        upload_data.at(i) = dev_mgr.get_queue(0, 1).enqueueMapBuffer(data_in.at(i), CL_FALSE, CL_MAP_WRITE_INVALIDATE_REGION, 0, var_size,
+                                                                     NULL, &map_upload_events.at(i));
       }
+
+      for (arg_target const& target : arg_targets.at(i)) {
+        target.kernel->setArg(target.arg_idx, data_in.at(i));
+      }
+    }
+    catch (cl::Error err) {
+      std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+    }
+  }
+  dev_mgr.get_queue(0, 1).flush();
+
+  for(cl_uint i = 0; i < data_names.size(); i++) {
+    if (upload_data.at(i) == nullptr) {
+      continue;
+    }
+
+    try {
+      map_upload_events.at(i).wait();
+      cl_ulong read_begin = trace.now();
+      h5_read_buffer(config_file, data_names.at(i).c_str(), data_types.at(i), upload_data.at(i));
+      cl_ulong read_end = trace.now();
+      read_times.at(i) = read_end - read_begin;
+      trace.add_host_stage("HDF5 read " + data_names.at(i), "hdf5", read_begin, read_end);
+      dev_mgr.get_queue(0, 1).enqueueUnmapMemObject(data_in.at(i), upload_data.at(i), NULL, &upload_events.at(i));
+      dev_mgr.get_queue(0, 1).flush();
     }
     catch (cl::Error err) {
       std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+      upload_data.at(i) = nullptr;
     }
   }
 
-  dev_mgr.get_queue(0, 0).finish(); // Buffer Copy is asynchronous
+  for (cl_uint i = 0; i < arg_names.size(); i++) {
+    size_t count = arg_sizes.at(i);
+    if (count != 1 && count != 2 && count != 3 && count != 4 && count != 8 && count != 16) {
+      cerr << ERROR_INFO << "Argument '" << arg_names.at(i) << "' with " << count << " elements is neither a scalar nor a vector." << endl;
+      return -1;
+    }
+
+    // 3-component vectors have the size of 4-component vectors
+    std::vector<char> value((count == 3 ? 4 : count) * h5_type_size(arg_types.at(i)), 0);
+    h5_read_buffer(config_file, arg_names.at(i).c_str(), arg_types.at(i), value.data());
+    h5_copy_object(config_file, out_file, arg_names.at(i).c_str());
 
+    try {
+      for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+        for (arg_target const& target : get_arg_targets(context_idx, data_names.size() + i)) {
+          target.kernel->setArg(target.arg_idx, value.size(), value.data());
+        }
+      }
+    }
+    catch (cl::Error err) {
+      std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+    }
+  }
+
+  // the uploads are still in flight; Data_LoadTime covers reading the HDF5 file and issuing the transfers
   push_time = timer.getTimeMicroseconds() - push_time;
+  stage_begin = end_phase("Data_Load", "HDF5 ingest and upload", stage_begin);
 
   cout << "Setting range..." << endl;
 
-  cl::NDRange range_start;
-  cl::NDRange global_range;
-  cl::NDRange local_range;
+  // the global ranges are the fallback of the per-kernel ranges in `/Ranges/<kernel>/`
+  kernel_ranges default_ranges;
+  if (!h5_check_object(config_file, "Global_Range")) {
+    cerr << ERROR_INFO << "Global_Range not found." << endl;
+    return -1;
+  }
+  read_ranges(config_file, "/", default_ranges);
+  write_ranges(out_file, "/", default_ranges);
+
+  std::map<std::string, kernel_ranges> ranges;
+  for (auto const& kernel_binding : kernel_bindings) {
+    string const& kernel_name = kernel_binding.first;
+    ranges[kernel_name] = default_ranges;
+
+    string group = "/Ranges/" + kernel_name;
+    if (h5_check_object(config_file, group.c_str())) {
+      read_ranges(config_file, group + "/", ranges[kernel_name]);
+      if (!h5_check_object(out_file, "/Ranges")) {
+        h5_create_dir(out_file, "/Ranges");
+      }
+      h5_create_dir(out_file, group.c_str());
+      write_ranges(out_file, group + "/", ranges[kernel_name]);
+    }
+  }
 
-  //TODO: Allow other integer types instead of cl_int?
-  cl_int tmp_range[3];
-  h5_read_buffer<cl_int>(filename, "Global_Range", tmp_range);
-  global_range = cl::NDRange(tmp_range[0], tmp_range[1], tmp_range[2]);
-  h5_write_buffer<cl_int>(out_name, "Global_Range", tmp_range, 3);
+  // The size of a __local argument with the attribute `per_work_item` is multiplied by the
+  // work-group size of the respective kernel. The local memory is checked per kernel and device,
+  // including the __local arrays declared in the kernel, which are queried before the __local
+  // arguments are set (their size is counted as zero while unset).
+  std::map<std::string, std::vector<cl_ulong>> static_local_mem_sizes;
+  for (auto const& kernel_binding : kernel_bindings) {
+    std::vector<cl_ulong>& static_sizes = static_local_mem_sizes[kernel_binding.first];
+    static_sizes.assign(num_contexts, 0);
+    try {
+      for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+        dev_mgr.getKernelbyName(context_idx, "ocl_Kernel", kernel_binding.first)->getWorkGroupInfo(
+          dev_mgr.get_context_dev_info(context_idx, 0).device, CL_KERNEL_LOCAL_MEM_SIZE, &static_sizes.at(context_idx));
+      }
+    }
+    catch (cl::Error err) {
+      std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+    }
+  }
 
-  h5_read_buffer<cl_int>(filename, "Range_Start", tmp_range);
-  range_start = cl::NDRange(tmp_range[0], tmp_range[1], tmp_range[2]);
-  h5_write_buffer<cl_int>(out_name, "Range_Start", tmp_range, 3);
+  std::map<std::string, cl_ulong> local_mem_sizes;
+  for (cl_uint i = 0; i < local_names.size(); i++) {
+    cl_ulong local_size = h5_read_single<cl_ulong>(config_file, local_names.at(i).c_str());
+    bool per_work_item = h5_check_attribute(config_file, local_names.at(i).c_str(), "per_work_item");
+    h5_copy_object(config_file, out_file, local_names.at(i).c_str());
 
-  h5_read_buffer<cl_int>(filename, "Local_Range", tmp_range);
-  h5_write_buffer<cl_int>(out_name, "Local_Range", tmp_range, 3);
-  if ((tmp_range[0]==0) && (tmp_range[1]==0) && (tmp_range[2]==0)) {
-    local_range = cl::NullRange;
+    for (auto const& kernel_binding : kernel_bindings) {
+      cl_int arg_idx = kernel_binding.second.at(data_names.size() + arg_names.size() + i);
+      if (arg_idx < 0) {
+        continue;
+      }
+
+      cl_ulong kernel_local_size = local_size;
+      if (per_work_item) {
+        cl_ulong const* local_range = ranges.at(kernel_binding.first).local_range;
+        if (local_range[0] == 0 && local_range[1] == 0 && local_range[2] == 0) {
+          cerr << ERROR_INFO << "The size of '" << local_names.at(i) << "' depends on the Local_Range of kernel '"
+               << kernel_binding.first << "', which is not set." << endl;
+          return -1;
+        }
+        for (cl_uint dim = 0; dim < 3; dim++) {
+          kernel_local_size *= std::max<cl_ulong>(local_range[dim], 1);
+        }
+      }
+      local_mem_sizes[kernel_binding.first] += kernel_local_size;
+
+      try {
+        for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+          dev_mgr.getKernelbyName(context_idx, "ocl_Kernel", kernel_binding.first)->setArg(arg_idx, cl::Local(kernel_local_size));
+        }
+      }
+      catch (cl::Error err) {
+        std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+      }
+    }
   }
-  else {
-    local_range = cl::NDRange(tmp_range[0], tmp_range[1], tmp_range[2]);
+
+  for (auto const& static_sizes : static_local_mem_sizes) {
+    for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+      cl_ulong required = static_sizes.second.at(context_idx) + local_mem_sizes[static_sizes.first];
+      cl_ulong available = dev_mgr.get_context_dev_info(context_idx, 0).local_mem;
+      if (required > available) {
+        cerr << ERROR_INFO << "Kernel '" << static_sizes.first << "' requires " << required << " bytes of local memory ("
+             << static_sizes.second.at(context_idx) << " bytes declared in the kernel, " << local_mem_sizes[static_sizes.first]
+             << " bytes of __local arguments), but only " << available << " bytes are available." << endl;
+        return -1;
+      }
+    }
+  }
+
+  // Launches with more work-items per dimension than supported by the device (or the size_t of
+  // the host) are split into several launches with adjusted offsets. The limit can be lowered
+  // by `Max_Launch_Range`, e.g. for drivers with undocumented restrictions.
+  cl_ulong max_launch_range = std::numeric_limits<size_t>::max();
+  for (cl_uint idx : device_indices) {
+    if (dev_mgr.get_avail_dev_info(idx).address_bits == 32) {
+      max_launch_range = std::min<cl_ulong>(max_launch_range, std::numeric_limits<cl_uint>::max());
+    }
+  }
+  if (h5_check_object(config_file, "Max_Launch_Range")) {
+    max_launch_range = std::min(max_launch_range, std::max<cl_ulong>(1, h5_read_single<cl_ulong>(config_file, "Max_Launch_Range")));
+  }
+  // the parts are whole work-groups, hence a work-group larger than the limit exceeds it
+  for (string const& kernel_name : kernel_list) {
+    cl_ulong const* local_range = ranges.at(kernel_name).local_range;
+    for (cl_uint dim = 0; dim < 3; dim++) {
+      if (local_range[dim] > max_launch_range) {
+        cerr << "Warning: Local_Range[" << dim << "] == " << local_range[dim] << " of kernel '" << kernel_name.c_str()
+             << "' exceeds the maximal launch range " << max_launch_range << ", the launch parts are single work-groups." << endl;
+      }
+    }
+  }
+
+  // In tiled and multi-device mode, the datasets are split into rows of their slowest varying
+  // dimension, which has to be the same for all bound datasets. The kernels are split along the
+  // highest dimension of their NDRange with more than one work-item, which has to match the rows.
+  cl_ulong num_rows = 0;
+  cl_ulong row_bytes = 0;
+  cl_ulong max_row_bytes = 0;
+  std::vector<cl_ulong> row_sizes(data_names.size(), 0);
+  std::map<std::string, cl_uint> split_dims;
+  cl_ulong row_multiple = 1;
+  if (tiled_mode || multi_device) {
+    if (h5_check_object(config_file, "Swap_Args")) {
+      cerr << ERROR_INFO << "Swap_Args is not supported in tiled or multi-device mode." << endl;
+      return -1;
+    }
+
+    // the rows are exchanged between the devices only between the repetitions, hence a kernel
+    // would read the rows written by an earlier kernel on another device before they arrive
+    if (multi_device && kernel_list.size() > 1) {
+      cerr << ERROR_INFO << "Several kernels are not supported in multi-device mode, since the rows written by a kernel "
+           << "are not exchanged with the other devices before the next kernel." << endl;
+      return -1;
+    }
+
+    for (cl_uint i = 0; i < data_names.size(); i++) {
+      if (arg_targets.at(i).empty()) {
+        continue;
+      }
+
+      std::vector<hsize_t> dims;
+      h5_get_dims(config_file, data_names.at(i).c_str(), dims);
+      cl_ulong rows = dims.empty() ? 1 : dims.at(0);
+      if (num_rows != 0 && rows != num_rows) {
+        cerr << ERROR_INFO << "All datasets need the same number of rows to be split, but '" << data_names.at(i)
+             << "' has " << rows << " instead of " << num_rows << " rows." << endl;
+        return -1;
+      }
+      num_rows = rows;
+      row_sizes.at(i) = data_sizes.at(i) / rows;
+      row_bytes += row_sizes.at(i) * h5_type_size(data_types.at(i));
+      max_row_bytes = std::max(max_row_bytes, row_sizes.at(i) * h5_type_size(data_types.at(i)));
+    }
+
+    // the parts have to be multiples of the work-group sizes
+    auto gcd = [](cl_ulong a, cl_ulong b) {
+      while (b != 0) {
+        cl_ulong tmp = a % b;
+        a = b;
+        b = tmp;
+      }
+      return a;
+    };
+
+    for (auto const& kernel_range : ranges) {
+      kernel_ranges const& item = kernel_range.second;
+      cl_uint dim = 2;
+      while (dim > 0 && item.global_range[dim] <= 1) {
+        --dim;
+      }
+      if (item.global_range[dim] != num_rows || item.range_start[dim] != 0) {
+        cerr << ERROR_INFO << "To be split, the Global_Range of kernel '" << kernel_range.first << "' in dimension " << dim
+             << " has to match the " << num_rows << " rows of the datasets, starting at 0." << endl;
+        return -1;
+      }
+      if (item.local_range[dim] > 0) {
+        row_multiple = row_multiple / gcd(row_multiple, item.local_range[dim]) * item.local_range[dim];
+      }
+      split_dims[kernel_range.first] = dim;
+    }
+  }
+
+  std::unique_ptr<tiled_executor> tiled;
+  if (tiled_mode) {
+    cl_ulong tile_rows = 0;
+    if (h5_check_object(config_file, "Tile_Size")) {
+      tile_rows = h5_read_single<cl_ulong>(config_file, "Tile_Size");
+    }
+    else {
+      // two sets of buffers using at most 3/4 of the device memory
+      cl_ulong buffer_rows = std::min(dev_info.max_mem * 3 / 8 / std::max<cl_ulong>(row_bytes, 1),
+                                      dev_info.max_mem_alloc / std::max<cl_ulong>(max_row_bytes, 1));
+      tile_rows = buffer_rows > 2 * halo ? buffer_rows - 2 * halo : 1;
+    }
+    tile_rows = std::max(tile_rows / row_multiple, (cl_ulong)1) * row_multiple;
+
+    tiled.reset(new tiled_executor(dev_mgr, 0, num_rows, tile_rows, halo));
+    cout << "Tiled mode: " << tiled->num_tiles() << " tiles of " << tile_rows << " rows" << endl;
+    h5_write_single<cl_ulong>(out_file, "Tile_Size", tile_rows);
+    h5_write_single<cl_ulong>(out_file, "Tile_Halo", halo);
+
+    std::vector<cl_int> dataset_idx(data_names.size(), -1);
+    for (cl_uint i = 0; i < data_names.size(); i++) {
+      if (arg_targets.at(i).empty()) {
+        continue;
+      }
+
+      tiled_executor::dataset data;
+      data.name = data_names.at(i);
+      data.type = data_types.at(i);
+      data.row_size = row_sizes.at(i);
+      data.rw_flag = data_rw_flags.at(i);
+      data.output = data_rw_flags.at(i) != 1;
+      data.compression = data_compressions.at(i);
+      data.targets = arg_targets.at(i);
+
+      dataset_idx.at(i) = tiled->num_datasets();
+      tiled->add_dataset(data);
+    }
+
+    for (string const& kernel_name : kernel_list) {
+      tiled_executor::launch item;
+      item.kernel = dev_mgr.getKernelbyName(0, "ocl_Kernel", kernel_name);
+      kernel_ranges const& launch_ranges = ranges.at(kernel_name);
+      std::copy(launch_ranges.range_start, launch_ranges.range_start + 3, item.range_start);
+      std::copy(launch_ranges.global_range, launch_ranges.global_range + 3, item.global_range);
+      std::copy(launch_ranges.local_range, launch_ranges.local_range + 3, item.local_range);
+      item.tile_dim = split_dims.at(kernel_name);
+      item.tile_offset_idx = tile_offset_args.at(kernel_name);
+      for (cl_uint i = 0; i < data_names.size(); i++) {
+        if (kernel_bindings.at(kernel_name).at(i) >= 0) {
+          item.buffers.push_back(dataset_idx.at(i));
+        }
+      }
+
+      tiled->add_launch(item);
+    }
+  }
+
+  // The datasets are replicated on all devices, which process a share of the rows each.
+  std::unique_ptr<multi_device_executor> multi;
+  if (multi_device) {
+    multi.reset(new multi_device_executor(dev_mgr, num_contexts, num_rows, row_multiple));
+    cout << "Multi-device mode: " << num_contexts << " devices" << endl;
+
+    std::vector<string> device_names;
+    for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+      device_names.push_back(dev_mgr.get_context_dev_info(context_idx, 0).name);
+    }
+    h5_write_strings(out_file, "OpenCL_Devices", device_names);
+
+    if (numa_mode) {
+      h5_write_single<cl_uint>(out_file, "NUMA_Nodes", num_contexts);
+      if (!multi->set_numa_affinity()) {
+        cerr << "Warning: The host threads cannot be pinned to the NUMA nodes." << endl;
+      }
+    }
+
+    std::vector<cl_int> dataset_idx(data_names.size(), -1);
+    for (cl_uint i = 0; i < data_names.size(); i++) {
+      if (arg_targets.at(i).empty()) {
+        continue;
+      }
+
+      multi_device_executor::dataset data;
+      data.name = data_names.at(i);
+      data.type = data_types.at(i);
+      data.row_size = row_sizes.at(i);
+      data.rw_flag = data_rw_flags.at(i);
+      data.output = data_rw_flags.at(i) != 1;
+      data.compression = data_compressions.at(i);
+      for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+        data.targets.push_back(get_arg_targets(context_idx, i));
+      }
+
+      dataset_idx.at(i) = multi->num_datasets();
+      multi->add_dataset(data);
+    }
+
+    for (string const& kernel_name : kernel_list) {
+      multi_device_executor::launch item;
+      item.kernel_name = kernel_name;
+      kernel_ranges const& launch_ranges = ranges.at(kernel_name);
+      std::copy(launch_ranges.range_start, launch_ranges.range_start + 3, item.range_start);
+      std::copy(launch_ranges.global_range, launch_ranges.global_range + 3, item.global_range);
+      std::copy(launch_ranges.local_range, launch_ranges.local_range + 3, item.local_range);
+      item.split_dim = split_dims.at(kernel_name);
+      for (cl_uint i = 0; i < data_names.size(); i++) {
+        if (kernel_bindings.at(kernel_name).at(i) >= 0) {
+          item.buffers.push_back(dataset_idx.at(i));
+        }
+      }
+
+      multi->add_launch(item);
+    }
+  }
+
+  // resolve all kernel launches once, outside of the repetition loop
+  exec_plan plan;
+  for (string const& kernel_name : kernel_list) {
+    if (tiled_mode || multi_device) {
+      break;
+    }
+
+    std::vector<cl_uint> kernel_buffers;
+    for (cl_uint i = 0; i < data_names.size(); i++) {
+      if (kernel_bindings.at(kernel_name).at(i) >= 0) {
+        kernel_buffers.push_back(i);
+      }
+    }
+
+    kernel_ranges const& launch_ranges = ranges.at(kernel_name);
+    plan.add_launch(dev_mgr.getKernelbyName(0, "ocl_Kernel", kernel_name), &dev_mgr.get_queue(0, 0),
+                    launch_ranges.range_start, launch_ranges.global_range, launch_ranges.local_range,
+                    max_launch_range, kernel_buffers);
+  }
+
+  // ping-pong buffers given as pairs of dataset names, swapped every `Swap_Interval` repetitions
+  std::vector<std::pair<cl_uint, cl_uint>> swap_pairs;
+  if (h5_check_object(config_file, "Swap_Args")) {
+    std::vector<std::string> swap_names;
+    h5_read_strings(config_file, "Swap_Args", swap_names);
+    if (swap_names.size() % 2 != 0) {
+      cerr << ERROR_INFO << "Swap_Args has to contain pairs of dataset names." << endl;
+      return -1;
+    }
+
+    std::vector<cl_uint> swap_idx(swap_names.size());
+    for (size_t j = 0; j < swap_names.size(); j++) {
+      auto it = find_if(data_names.begin(), data_names.end(), [&](std::string const& name) {
+        return name == swap_names.at(j) || name.substr(name.find_last_of('/') + 1) == swap_names.at(j);
+      });
+      if (it == data_names.end()) {
+        cerr << ERROR_INFO << "Swap argument '" << swap_names.at(j) << "' not found in /Data." << endl;
+        return -1;
+      }
+      swap_idx.at(j) = distance(data_names.begin(), it);
+    }
+
+    for (size_t j = 0; j < swap_idx.size(); j += 2) {
+      cl_uint a = swap_idx.at(j);
+      cl_uint b = swap_idx.at(j + 1);
+      if (data_sizes.at(a) != data_sizes.at(b) || data_types.at(a) != data_types.at(b)) {
+        cerr << ERROR_INFO << "Swapped datasets '" << data_names.at(a) << "' and '" << data_names.at(b) << "' differ in type or size." << endl;
+        return -1;
+      }
+      if (arg_targets.at(a).empty() || arg_targets.at(b).empty()) {
+        cerr << ERROR_INFO << "Swapped datasets '" << data_names.at(a) << "' and '" << data_names.at(b) << "' have to be bound to a kernel." << endl;
+        return -1;
+      }
+      swap_pairs.push_back(std::make_pair(a, b));
+      plan.add_swap(a, &data_in.at(a), arg_targets.at(a), b, &data_in.at(b), arg_targets.at(b));
+    }
+
+    if (h5_check_object(config_file, "Swap_Interval")) {
+      plan.set_swap_interval(std::max<cl_ulong>(1, h5_read_single<cl_ulong>(config_file, "Swap_Interval")));
+    }
+  }
+
+  for (cl_uint i = 0; i < data_names.size(); i++) {
+    if (upload_data.at(i) != nullptr) {
+      plan.add_buffer_dependency(i, upload_events.at(i));
+    }
   }
 
 #if defined(USENVML)
+  // the sensor samples are timestamped with the wall clock
+  timeval nv_wall_time;
+  gettimeofday(&nv_wall_time, NULL);
+  cl_ulong nv_host_time = trace.now();
+
   cout << "Using NVML interface..." << endl << endl;
   std::thread nv_log_pwr_thread(nv_log_pwr_func);
   std::thread nv_log_tmp_thread(nv_log_tmp_func);
@@ -501,20 +1369,92 @@ int main(int argc, char *argv[]) {
 
 
   uint64_t exec_time = 0;
-  uint32_t kernels_run=0;
+  uint64_t kernels_run=0;
+
+  // The readback is issued on the copy queue and double buffered: while dataset i is written
+  // (and compressed), the non-blocking map of dataset i+1 is already in flight. In asynchronous
+  // mode, the first maps only wait for the last kernel accessing the buffer, such that the
+  // readback can begin while trailing kernels are still running.
+  std::vector<void*> mapped_data(data_names.size(), nullptr);
+  std::vector<cl::Event> map_events(data_names.size());
+
+  auto map_output = [&](cl_uint i) {
+    if (mapped_data.at(i) != nullptr) {
+      return;
+    }
+
+    try {
+      size_t var_size = data_sizes.at(i) * h5_type_size(data_types.at(i));
+      std::vector<cl::Event> wait_events;
+      plan.get_buffer_events(i, wait_events);
+      mapped_data.at(i) = dev_mgr.get_queue(0, 1).enqueueMapBuffer(data_in.at(i), CL_FALSE, CL_MAP_READ, 0, var_size,
+                                                                   wait_events.empty() ? NULL : &wait_events, &map_events.at(i));
+      dev_mgr.get_queue(0, 1).flush();
+    }
+    catch (cl::Error err) {
+      std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+    }
+  };
+
+  // datasets which are bound to a kernel and not read_only are read back
+  auto is_output = [&](cl_uint i) {
+    return data_rw_flags.at(i) != 1 && !arg_targets.at(i).empty();
+  };
+
+  // index of the first dataset starting at `i` which has to be read back
+  auto next_readback = [&](cl_uint i) {
+    while (i < data_names.size() && !is_output(i)) {
+      ++i;
+    }
+    return i;
+  };
 
   uint64_t total_exec_time = timer.getTimeMicroseconds();
+  stage_begin = end_phase("Launch_Setup", "Launch setup", stage_begin);
 
-  for (cl_ulong repetition = 0; repetition < kernel_repetitions; ++repetition) {
-    for (string const& kernel_name : kernel_list) {
-      exec_time = exec_time + dev_mgr.execute_kernelNA(*(dev_mgr.getKernelbyName(0, "ocl_Kernel", kernel_name)),
-                                                       dev_mgr.get_queue(0, 0), range_start, global_range, local_range);
-      kernels_run++;
+  cl_uint next_output = 0;
+  if (tiled) {
+    // the tiles are streamed from the configuration file to the output file
+    exec_time = tiled->execute(config_file, out_file, kernel_repetitions, max_launch_range);
+    kernels_run = kernel_list.size() * kernel_repetitions * tiled->num_tiles();
+  }
+  else if (multi) {
+    // the results are gathered from all devices into the output file
+    exec_time = multi->execute(config_file, out_file, kernel_repetitions, max_launch_range);
+    kernels_run = kernel_list.size() * kernel_repetitions * multi->num_devices();
+
+    std::vector<cl_ulong> device_rows = multi->get_device_rows();
+    h5_write_buffer<cl_ulong>(out_file, "Device_Rows", device_rows.data(), device_rows.size());
+  }
+  else {
+    exec_time = plan.execute(dev_mgr, kernel_repetitions, async_mode);
+    next_output = next_readback(0);
+    if (next_output < data_names.size()) {
+      map_output(next_output);
+      next_output = next_readback(next_output + 1);
+      if (next_output < data_names.size()) {
+        map_output(next_output);
+      }
     }
+    exec_time += plan.finish(dev_mgr);
+    kernels_run = plan.size() * kernel_repetitions;
   }
 
   total_exec_time = timer.getTimeMicroseconds() - total_exec_time;
-  h5_write_single<double>(out_name, "Total_ExecTime", (double)total_exec_time / 1000.0);
+  stage_begin = end_phase("Kernel_Loop", "Kernel loop", stage_begin);
+  h5_write_single<double>(out_file, "Total_ExecTime", (double)total_exec_time / 1000.0);
+
+  // timing of the single launches, in the order of `kernel_list`
+  std::vector<std::vector<exec_plan::launch_timing>> launch_times;
+  if (tiled) {
+    launch_times = tiled->get_launch_times();
+  }
+  else if (multi) {
+    launch_times = multi->get_launch_times();
+  }
+  else {
+    plan.append_launch_times(launch_times);
+  }
 
 
   cout << "Kernels executed: " << kernels_run << endl;
@@ -537,11 +1477,15 @@ int main(int argc, char *argv[]) {
 
   std::vector<std::string> time_strings;
 
-  h5_create_dir(out_name, "/NV_HK");
+  h5_create_dir(out_file, "/NV_HK");
 
   if (nv_p_rate>0) {
 
-    h5_write_buffer<cl_uint>(out_name, "/NV_HK/NV_Power", nv_pwr.data(), nv_pwr.size());
+    h5_write_buffer<cl_uint>(out_file, "/NV_HK/NV_Power", nv_pwr.data(), nv_pwr.size());
+    for (size_t i = 0; i < nv_pwr_time.size(); i++) {
+      cl_long wall_offset = (nv_pwr_time.at(i).tv_sec - nv_wall_time.tv_sec) * 1000000000LL + (nv_pwr_time.at(i).tv_usec - nv_wall_time.tv_usec) * 1000LL;
+      trace.add_counter("NV_Power [mW]", nv_host_time + wall_offset, nv_pwr.at(i));
+    }
 
     for(size_t i = 0; i < nv_pwr_time.size(); i++) {
       char time_buffer[100];
@@ -552,13 +1496,17 @@ int main(int argc, char *argv[]) {
       time_strings.push_back(time_buffer);
     }
 
-    h5_write_strings(out_name, "/NV_HK/NV_Power_Time", time_strings);
+    h5_write_strings(out_file, "/NV_HK/NV_Power_Time", time_strings);
     time_strings.clear();
   }
 
   if (nv_t_rate>0) {
 
-    h5_write_buffer<cl_ushort>(out_name, "/NV_HK/NV_Temperature", nv_tmp.data(), nv_tmp.size());
+    h5_write_buffer<cl_ushort>(out_file, "/NV_HK/NV_Temperature", nv_tmp.data(), nv_tmp.size());
+    for (size_t i = 0; i < nv_tmp_time.size(); i++) {
+      cl_long wall_offset = (nv_tmp_time.at(i).tv_sec - nv_wall_time.tv_sec) * 1000000000LL + (nv_tmp_time.at(i).tv_usec - nv_wall_time.tv_usec) * 1000LL;
+      trace.add_counter("NV_Temperature [C]", nv_host_time + wall_offset, nv_tmp.at(i));
+    }
 
     for(size_t i = 0; i < nv_tmp_time.size(); i++) {
       char time_buffer[100];
@@ -569,7 +1517,7 @@ int main(int argc, char *argv[]) {
       time_strings.push_back(time_buffer);
     }
 
-    h5_write_strings(out_name, "/NV_HK/NV_Temperature_Time", time_strings);
+    h5_write_strings(out_file, "/NV_HK/NV_Temperature_Time", time_strings);
     time_strings.clear();
   }
 #endif
@@ -578,72 +1526,206 @@ int main(int argc, char *argv[]) {
   char time_buffer[80];
   strftime(time_buffer, sizeof(time_buffer), "%d-%m-%Y %H:%M:%S", timeinfo);
 
-  h5_write_string(out_name, "Kernel_ExecStart", time_buffer);
-  h5_write_string(out_name, "OpenCL_Device", dev_mgr.get_avail_dev_info(deviceIndex).name.c_str());
-  h5_write_string(out_name, "OpenCL_Version", dev_mgr.get_avail_dev_info(deviceIndex).ocl_version.c_str());
-  h5_write_single<double>(out_name,"Kernel_ExecTime", (double)exec_time/1000.0);
-  h5_write_single<double>(out_name, "Data_LoadTime", (double)push_time/1000.0);
-
-  h5_create_dir(out_name, "/Data");
+  h5_write_string(out_file, "Kernel_ExecStart", time_buffer);
+  h5_write_string(out_file, "OpenCL_Device", dev_mgr.get_avail_dev_info(deviceIndex).name.c_str());
+  h5_write_string(out_file, "OpenCL_Version", dev_mgr.get_avail_dev_info(deviceIndex).ocl_version.c_str());
+  h5_write_single<double>(out_file,"Kernel_ExecTime", (double)exec_time/1000.0);
+
+  // the launch durations and profiles grouped by kernel, in the order of execution
+  std::map<std::string, std::vector<double>> kernel_durations;
+  std::map<std::string, std::vector<ocl_dev_mgr::profiling_info>> kernel_profiles;
+  double queue_latency = 0.0;
+  double device_time = 0.0;
+  size_t max_launches = 0;
+  for (std::vector<exec_plan::launch_timing> const& times : launch_times) {
+    max_launches = std::max(max_launches, times.size());
+  }
+  for (size_t idx = 0; idx < max_launches; idx++) {
+    for (size_t launch_idx = 0; launch_idx < launch_times.size() && launch_idx < kernel_list.size(); launch_idx++) {
+      if (idx < launch_times.at(launch_idx).size()) {
+        exec_plan::launch_timing const& timing = launch_times.at(launch_idx).at(idx);
+        kernel_durations[kernel_list.at(launch_idx)].push_back(timing.duration / 1.0e6);
+        kernel_profiles[kernel_list.at(launch_idx)].push_back(timing.profile);
+        queue_latency += (timing.profile.start - timing.profile.queued) / 1.0e6;
+        device_time += (timing.profile.end - timing.profile.start) / 1.0e6;
+      }
+    }
+  }
+  h5_write_single<double>(out_file, "Kernel_QueueLatency", queue_latency);
+  h5_write_single<double>(out_file, "Kernel_DeviceTime", device_time);
+  cout << "Kernel queue latency: " << queue_latency << " ms, device time: " << device_time << " ms" << endl;
+
+  h5_create_dir(out_file, "/Timing");
+  for (auto const& durations : kernel_durations) {
+    write_timing(out_file, "/Timing/" + durations.first, durations.second);
+    write_profiles(out_file, "/Timing/" + durations.first, kernel_profiles.at(durations.first));
+  }
+  h5_write_single<double>(out_file, "Data_LoadTime", (double)push_time/1000.0);
 
   pull_time = timer.getTimeMicroseconds();
-
-  uint32_t buffer_counter = 0;
+  stage_begin = end_phase("Timing_Output", "Timing and sensor output", stage_begin);
 
   for(cl_uint i = 0; i < data_names.size(); i++) {
+    if (!is_output(i)) {
+      // unchanged data, copied without decompressing and compressing it again
+      cl_ulong write_begin = trace.now();
+      h5_copy_object(config_file, out_file, data_names.at(i).c_str());
+      write_times.at(i) = trace.now() - write_begin;
+      continue;
+    }
+
+    if (tiled_mode || multi_device) {
+      // already written by the tiled or multi-device executor
+      h5_write_compression_attributes(out_file, data_names.at(i).c_str(), data_compressions.at(i));
+      continue;
+    }
+
+    next_output = next_readback(i + 1);
+    if (next_output < data_names.size()) {
+      map_output(next_output);
+    }
+
+    if (mapped_data.at(i) == nullptr) {
+      continue;
+    }
+
     try {
-      uint8_t *tmp_data = nullptr;
-      size_t var_size = 0;
-
-      switch (data_types.at(i)) {
-        case H5_float:  var_size=data_sizes.at(i)*sizeof(cl_float);  break;
-        case H5_double: var_size=data_sizes.at(i)*sizeof(cl_double); break;
-        case H5_char:   var_size=data_sizes.at(i)*sizeof(cl_char);   break;
-        case H5_uchar:  var_size=data_sizes.at(i)*sizeof(cl_uchar);  break;
-        case H5_short:  var_size=data_sizes.at(i)*sizeof(cl_short);  break;
-        case H5_ushort: var_size=data_sizes.at(i)*sizeof(cl_ushort); break;
-        case H5_int:    var_size=data_sizes.at(i)*sizeof(cl_int);    break;
-        case H5_uint:   var_size=data_sizes.at(i)*sizeof(cl_uint);   break;
-        case H5_long:   var_size=data_sizes.at(i)*sizeof(cl_long);   break;
-        case H5_ulong:  var_size=data_sizes.at(i)*sizeof(cl_ulong);  break;
-        default: cerr << ERROR_INFO << "Data type '" << data_types.at(i) << "' unknown." << endl;
-      }
-
-      tmp_data = new uint8_t[var_size];
-
-      switch (data_rw_flags.at(buffer_counter)) {
-        case 0: dev_mgr.get_queue(0, 0).enqueueReadBuffer(data_in.at(buffer_counter), blocking, 0, var_size, tmp_data); break;
-        case 1: break;
-        case 2: dev_mgr.get_queue(0, 0).enqueueReadBuffer(data_in.at(buffer_counter), blocking, 0, var_size, tmp_data); break;
-      }
-
-      dev_mgr.get_queue(0, 0).finish(); //Buffer Copy is asynchronous
-
-      switch (data_types.at(i)){
-        case H5_float:  h5_write_buffer<float>(    out_name, data_names.at(i).c_str(), (float*)tmp_data,     data_sizes.at(buffer_counter)); break;
-        case H5_double: h5_write_buffer<double>(   out_name, data_names.at(i).c_str(), (double*)tmp_data,    data_sizes.at(buffer_counter)); break;
-        case H5_char:   h5_write_buffer<cl_char>(  out_name, data_names.at(i).c_str(), (cl_char*)tmp_data,   data_sizes.at(buffer_counter)); break;
-        case H5_uchar:  h5_write_buffer<cl_uchar>( out_name, data_names.at(i).c_str(), (cl_uchar*)tmp_data,  data_sizes.at(buffer_counter)); break;
-        case H5_short:  h5_write_buffer<cl_short>( out_name, data_names.at(i).c_str(), (cl_short*)tmp_data,  data_sizes.at(buffer_counter)); break;
-        case H5_ushort: h5_write_buffer<cl_ushort>(out_name, data_names.at(i).c_str(), (cl_ushort*)tmp_data, data_sizes.at(buffer_counter)); break;
-        case H5_int:    h5_write_buffer<cl_int>(   out_name, data_names.at(i).c_str(), (cl_int*)tmp_data,    data_sizes.at(buffer_counter)); break;
-        case H5_uint:   h5_write_buffer<cl_uint>(  out_name, data_names.at(i).c_str(), (cl_uint*)tmp_data,   data_sizes.at(buffer_counter)); break;
-        case H5_long:   h5_write_buffer<cl_long>(  out_name, data_names.at(i).c_str(), (cl_long*)tmp_data,   data_sizes.at(buffer_counter)); break;
-        case H5_ulong:  h5_write_buffer<cl_ulong>( out_name, data_names.at(i).c_str(), (cl_ulong*)tmp_data,  data_sizes.at(buffer_counter)); break;
-        default: cerr << ERROR_INFO << "Data type '" << data_types.at(i) << "' unknown." << endl;
-      }
-      if (tmp_data != nullptr) {
-        delete[] tmp_data; tmp_data = nullptr;
-      }
-      buffer_counter++;
+      h5_compression const& data_compression = data_compressions.at(i);
+
+      // the results are written from the mapped buffer directly into the HDF5 file
+      map_events.at(i).wait();
+      cl_ulong write_begin = trace.now();
+      h5_write_buffer(out_file, data_names.at(i).c_str(), data_types.at(i), mapped_data.at(i), data_sizes.at(i), data_compression);
+      cl_ulong write_end = trace.now();
+      write_times.at(i) = write_end - write_begin;
+      trace.add_host_stage("HDF5 write " + data_names.at(i), "hdf5", write_begin, write_end);
+      dev_mgr.get_queue(0, 1).enqueueUnmapMemObject(data_in.at(i), mapped_data.at(i));
+      h5_write_compression_attributes(out_file, data_names.at(i).c_str(), data_compression);
     }
     catch (cl::Error err) {
       std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
     }
   }
 
+  dev_mgr.get_queue(0, 1).finish();
+
+  // profiles of the uploads (unmap) and readbacks (map) on the copy queue
+  std::vector<std::string> upload_names, readback_names;
+  std::vector<ocl_dev_mgr::profiling_info> upload_profiles, readback_profiles;
+  for (cl_uint i = 0; i < data_names.size(); i++) {
+    ocl_dev_mgr::profiling_info profile;
+    if (upload_data.at(i) != nullptr && dev_mgr.get_profiling_info(upload_events.at(i), profile)) {
+      upload_names.push_back(data_names.at(i));
+      upload_profiles.push_back(profile);
+    }
+    if (!tiled_mode && !multi_device && is_output(i) && mapped_data.at(i) != nullptr && dev_mgr.get_profiling_info(map_events.at(i), profile)) {
+      readback_names.push_back(data_names.at(i));
+      readback_profiles.push_back(profile);
+    }
+  }
+  if (!upload_profiles.empty() || !readback_profiles.empty()) {
+    h5_create_dir(out_file, "/Timing/Transfers");
+  }
+  if (!upload_profiles.empty()) {
+    write_profiles(out_file, "/Timing/Transfers/Upload", upload_profiles);
+    h5_write_strings(out_file, "/Timing/Transfers/Upload/Names", upload_names);
+  }
+  if (!readback_profiles.empty()) {
+    write_profiles(out_file, "/Timing/Transfers/Readback", readback_profiles);
+    h5_write_strings(out_file, "/Timing/Transfers/Readback/Names", readback_names);
+  }
+
+  // HDF5 and transfer times per dataset; the tiled and multi-device executors transfer the bound
+  // datasets internally and provide their times, the unbound ones are copied here
+  if (!data_names.empty()) {
+    std::vector<h5_transfer_record> executor_records;
+    if (tiled) {
+      executor_records = tiled->get_transfer_records();
+    }
+    else if (multi) {
+      executor_records = multi->get_transfer_records();
+    }
+
+    std::vector<h5_transfer_record> records(data_names.size());
+    for (cl_uint i = 0; i < data_names.size(); i++) {
+      h5_transfer_record& record = records.at(i);
+      record.name = std::string(data_names.at(i).c_str());
+      record.bytes = data_sizes.at(i) * h5_type_size(data_types.at(i));
+      record.read_time = read_times.at(i) / 1.0e6;
+      record.upload_time = 0.0;
+      record.download_time = 0.0;
+      record.write_time = write_times.at(i) / 1.0e6;
+
+      for (h5_transfer_record const& executor_record : executor_records) {
+        if (executor_record.name == data_names.at(i)) {
+          record.read_time += executor_record.read_time;
+          record.upload_time = executor_record.upload_time;
+          record.download_time = executor_record.download_time;
+          record.write_time += executor_record.write_time;
+        }
+      }
+
+      ocl_dev_mgr::profiling_info profile;
+      if (upload_data.at(i) != nullptr && dev_mgr.get_profiling_info(upload_events.at(i), profile)) {
+        record.upload_time = (profile.end - profile.start) / 1.0e6;
+      }
+      if (!tiled_mode && !multi_device && is_output(i) && mapped_data.at(i) != nullptr && dev_mgr.get_profiling_info(map_events.at(i), profile)) {
+        record.download_time = (profile.end - profile.start) / 1.0e6;
+      }
+    }
+    if (!h5_check_object(out_file, "/Timing/Transfers")) {
+      h5_create_dir(out_file, "/Timing/Transfers");
+    }
+    h5_write_transfer_table(out_file, "/Timing/Transfers/Datasets", records);
+  }
+  stage_begin = end_phase("Data_Store", "Readback and HDF5 write", stage_begin);
+
+  // the datasets contain the physical buffers; `bound_to` names the dataset whose kernel
+  // arguments the buffer is bound to after the last repetition
+  if (!swap_pairs.empty()) {
+    h5_write_single<cl_ulong>(out_file, "Swap_Count", plan.get_swap_count());
+    for (size_t j = 0; j < swap_pairs.size(); j++) {
+      std::string const& name_a = data_names.at(swap_pairs.at(j).first);
+      std::string const& name_b = data_names.at(swap_pairs.at(j).second);
+      h5_write_attribute_string(out_file, name_a.c_str(), "bound_to", plan.is_swapped(j) ? name_b.c_str() : name_a.c_str());
+      h5_write_attribute_string(out_file, name_b.c_str(), "bound_to", plan.is_swapped(j) ? name_a.c_str() : name_b.c_str());
+    }
+  }
+
   pull_time = timer.getTimeMicroseconds() - pull_time;
-  h5_write_single<double>(out_name, "Data_StoreTime", (double)pull_time / 1000.0);
+  h5_write_single<double>(out_file, "Data_StoreTime", (double)pull_time / 1000.0);
+
+  // the phases cover the run from the enumeration of the devices; `Total` is measured from the
+  // start of the program
+  h5_create_dir(out_file, "/Host_Timing");
+  for (auto const& phase : host_phases) {
+    h5_write_single<double>(out_file, ("/Host_Timing/" + phase.first).c_str(), phase.second);
+  }
+  h5_write_single<double>(out_file, "/Host_Timing/Total", trace.now() / 1.0e6);
+  h5_write_buffer<double>(out_file, "/Host_Timing/Compile_Times", compile_times.data(), compile_times.size());
+  h5_write_strings(out_file, "/Host_Timing/Build_Logs", build_logs);
+
+  if (!trace_filename.empty()) {
+    // the second calibration accounts for the drift of the device clocks during the run
+    for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+      trace.calibrate(dev_mgr, context_idx);
+    }
+    for (size_t launch_idx = 0; launch_idx < launch_times.size() && launch_idx < kernel_list.size(); launch_idx++) {
+      for (exec_plan::launch_timing const& timing : launch_times.at(launch_idx)) {
+        trace.add_device_command(timing.context_idx, 0, kernel_list.at(launch_idx), "kernel", timing.profile);
+      }
+    }
+    for (size_t i = 0; i < upload_profiles.size(); i++) {
+      trace.add_device_command(0, 1, "Upload " + upload_names.at(i), "transfer", upload_profiles.at(i));
+    }
+    for (size_t i = 0; i < readback_profiles.size(); i++) {
+      trace.add_device_command(0, 1, "Readback " + readback_names.at(i), "transfer", readback_profiles.at(i));
+    }
+
+    if (trace.write(trace_filename)) {
+      cout << "Trace written to " << trace_filename << endl;
+    }
+  }
 
   return 0;
 }
@@ -0,0 +1,512 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include "multi_device.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "util.hpp"
+
+
+// CPUs of the NUMA nodes as given by the Linux sysfs, e.g. `0-7,16-23`
+static void read_numa_cpus(std::vector<std::vector<int>>& node_cpus)
+{
+  node_cpus.clear();
+  for (int node = 0; ; node++) {
+    std::ifstream cpu_file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    if (!cpu_file.is_open()) {
+      break;
+    }
+
+    std::vector<int> cpus;
+    std::string range;
+    while (std::getline(cpu_file, range, ',')) {
+      int first = 0, last = 0;
+      char dash = 0;
+      std::istringstream range_stream(range);
+      range_stream >> first;
+      if (!(range_stream >> dash >> last)) {
+        last = first;
+      }
+      for (int cpu = first; cpu <= last; cpu++) {
+        cpus.push_back(cpu);
+      }
+    }
+    node_cpus.push_back(cpus);
+  }
+}
+
+
+static bool pin_thread(std::vector<int> const& cpus)
+{
+#if defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (int cpu : cpus) {
+    CPU_SET(cpu, &cpu_set);
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+  return false;
+#endif
+}
+
+
+multi_device_executor::multi_device_executor(ocl_dev_mgr& dev_mgr, cl_uint num_contexts, cl_ulong num_rows, cl_ulong row_multiple)
+  : dev_mgr(dev_mgr), num_contexts(num_contexts), num_rows(num_rows), row_multiple(std::max<cl_ulong>(row_multiple, 1)),
+    throughput(num_contexts, 0.0)
+{
+}
+
+
+std::vector<cl_ulong> multi_device_executor::get_device_rows() const
+{
+  std::vector<cl_ulong> device_rows(num_contexts, 0);
+  for (cl_uint context_idx = 0; context_idx < num_contexts && context_idx + 1 < row_begin.size(); context_idx++) {
+    device_rows.at(context_idx) = row_begin.at(context_idx + 1) - row_begin.at(context_idx);
+  }
+  return device_rows;
+}
+
+
+bool multi_device_executor::set_numa_affinity()
+{
+#if defined(__linux__)
+  std::vector<std::vector<int>> node_cpus;
+  read_numa_cpus(node_cpus);
+  if (node_cpus.size() != num_contexts) {
+    return false;
+  }
+
+  host_cpus = node_cpus;
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+// The rows are split proportionally to the measured throughput. Devices which have not been
+// measured yet get the mean throughput of the others, i.e. the first split is an even one.
+void multi_device_executor::partition()
+{
+  double sum_known = 0.0;
+  cl_uint num_known = 0;
+  for (double value : throughput) {
+    if (value > 0.0) {
+      sum_known += value;
+      ++num_known;
+    }
+  }
+
+  std::vector<double> weights(num_contexts, num_known > 0 ? sum_known / num_known : 1.0);
+  double total = 0.0;
+  for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+    if (throughput.at(context_idx) > 0.0) {
+      weights.at(context_idx) = throughput.at(context_idx);
+    }
+    total += weights.at(context_idx);
+  }
+
+  // the last device gets the rows which do not fill a multiple of `row_multiple`
+  cl_ulong units = num_rows / row_multiple;
+  double cumulative = 0.0;
+  row_begin.assign(num_contexts + 1, 0);
+  for (cl_uint context_idx = 1; context_idx < num_contexts; context_idx++) {
+    cumulative += weights.at(context_idx - 1);
+    cl_ulong begin = (cl_ulong)(cumulative / total * units + 0.5) * row_multiple;
+    row_begin.at(context_idx) = std::min(num_rows, std::max(begin, row_begin.at(context_idx - 1)));
+  }
+  row_begin.at(num_contexts) = num_rows;
+}
+
+
+bool multi_device_executor::upload(h5_file const& config_file)
+{
+  host_data.assign(datasets.size(), std::vector<char>());
+  transfers.assign(num_contexts, std::vector<cl::Event>(datasets.size()));
+
+  for (size_t idx = 0; idx < datasets.size(); idx++) {
+    dataset const& data = datasets.at(idx);
+    host_data.at(idx).resize(num_rows * row_bytes(idx));
+    if (data.rw_flag == 2) {
+      continue;
+    }
+
+    cl_ulong read_begin = timer.getTimeNanoseconds();
+    if (!h5_read_buffer(config_file, data.name.c_str(), data.type, host_data.at(idx).data())) {
+      return false;
+    }
+    transfer_records.at(idx).read_time = (timer.getTimeNanoseconds() - read_begin) / 1.0e6;
+    if (!host_cpus.empty()) {
+      continue;
+    }
+
+    try {
+      for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+        cl::CommandQueue& queue = dev_mgr.get_queue(context_idx, 1);
+        queue.enqueueWriteBuffer(buffers.at(context_idx).at(idx), CL_FALSE, 0, host_data.at(idx).size(), host_data.at(idx).data(),
+                                 NULL, &transfers.at(context_idx).at(idx));
+        queue.flush();
+      }
+    }
+    catch (cl::Error err) {
+      std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+      return false;
+    }
+  }
+
+  // the buffers are filled by one pinned thread per NUMA node
+  if (!host_cpus.empty()) {
+    std::vector<char> success(num_contexts, 0);
+    std::vector<std::thread> threads;
+    for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+      threads.push_back(std::thread([this, context_idx, &success]() {
+        success.at(context_idx) = first_touch(context_idx);
+      }));
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+
+    if (std::count(success.begin(), success.end(), 0) != 0) {
+      return false;
+    }
+  }
+
+  // write_only datasets are only initialized by the first touch
+  for (size_t idx = 0; idx < datasets.size(); idx++) {
+    if (datasets.at(idx).rw_flag == 2) {
+      continue;
+    }
+    for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+      upload_events.at(idx).push_back(transfers.at(context_idx).at(idx));
+    }
+  }
+
+  return true;
+}
+
+
+// The buffers are allocated with CL_MEM_ALLOC_HOST_PTR and mapped, such that the pages of CPU
+// devices are first touched by this thread on the node of the sub-device.
+bool multi_device_executor::first_touch(cl_uint context_idx)
+{
+  pin_thread(host_cpus.at(context_idx));
+  cl::CommandQueue& queue = dev_mgr.get_queue(context_idx, 1);
+
+  try {
+    for (size_t idx = 0; idx < datasets.size(); idx++) {
+      size_t var_size = host_data.at(idx).size();
+      void* mapped_data = queue.enqueueMapBuffer(buffers.at(context_idx).at(idx), CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, var_size);
+      if (datasets.at(idx).rw_flag == 2) {
+        memset(mapped_data, 0, var_size);
+      }
+      else {
+        memcpy(mapped_data, host_data.at(idx).data(), var_size);
+      }
+      queue.enqueueUnmapMemObject(buffers.at(context_idx).at(idx), mapped_data, NULL, &transfers.at(context_idx).at(idx));
+    }
+    queue.flush();
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+// Every device reads back its own rows of the read_write datasets and receives all other rows.
+// write_only datasets are not read by the kernels and read_only ones are never changed.
+bool multi_device_executor::exchange()
+{
+  try {
+    std::vector<cl::Event> read_events;
+    for (size_t idx = 0; idx < datasets.size(); idx++) {
+      if (datasets.at(idx).rw_flag != 0) {
+        continue;
+      }
+
+      for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+        cl_ulong rows = row_begin.at(context_idx + 1) - row_begin.at(context_idx);
+        if (rows == 0) {
+          continue;
+        }
+
+        size_t offset = row_begin.at(context_idx) * row_bytes(idx);
+        read_events.push_back(cl::Event());
+        dev_mgr.get_queue(context_idx, 1).enqueueReadBuffer(buffers.at(context_idx).at(idx), CL_FALSE, offset, rows * row_bytes(idx),
+                                                            host_data.at(idx).data() + offset, NULL, &read_events.back());
+        readback_events.at(idx).push_back(read_events.back());
+      }
+    }
+    for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+      dev_mgr.get_queue(context_idx, 1).flush();
+    }
+    if (!read_events.empty()) {
+      cl::Event::waitForEvents(read_events);
+    }
+
+    // the writes are in order on the copy queue, hence the last one covers the dataset
+    for (size_t idx = 0; idx < datasets.size(); idx++) {
+      if (datasets.at(idx).rw_flag != 0) {
+        continue;
+      }
+
+      for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+        cl::CommandQueue& queue = dev_mgr.get_queue(context_idx, 1);
+        size_t begin = row_begin.at(context_idx) * row_bytes(idx);
+        size_t end = row_begin.at(context_idx + 1) * row_bytes(idx);
+        if (begin > 0) {
+          queue.enqueueWriteBuffer(buffers.at(context_idx).at(idx), CL_FALSE, 0, begin, host_data.at(idx).data(),
+                                   NULL, &transfers.at(context_idx).at(idx));
+          upload_events.at(idx).push_back(transfers.at(context_idx).at(idx));
+        }
+        if (end < host_data.at(idx).size()) {
+          queue.enqueueWriteBuffer(buffers.at(context_idx).at(idx), CL_FALSE, end, host_data.at(idx).size() - end,
+                                   host_data.at(idx).data() + end, NULL, &transfers.at(context_idx).at(idx));
+          upload_events.at(idx).push_back(transfers.at(context_idx).at(idx));
+        }
+      }
+    }
+    for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+      dev_mgr.get_queue(context_idx, 1).flush();
+    }
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+// all reads are enqueued first, such that writing dataset i overlaps with the reads of i+1
+bool multi_device_executor::gather(h5_file const& out_file)
+{
+  std::vector<std::vector<cl::Event>> read_events(datasets.size());
+
+  try {
+    for (size_t idx = 0; idx < datasets.size(); idx++) {
+      if (!datasets.at(idx).output) {
+        continue;
+      }
+
+      for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+        cl_ulong rows = row_begin.at(context_idx + 1) - row_begin.at(context_idx);
+        if (rows == 0) {
+          continue;
+        }
+
+        size_t offset = row_begin.at(context_idx) * row_bytes(idx);
+        read_events.at(idx).push_back(cl::Event());
+        dev_mgr.get_queue(context_idx, 1).enqueueReadBuffer(buffers.at(context_idx).at(idx), CL_FALSE, offset, rows * row_bytes(idx),
+                                                            host_data.at(idx).data() + offset, NULL, &read_events.at(idx).back());
+        readback_events.at(idx).push_back(read_events.at(idx).back());
+      }
+    }
+    for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+      dev_mgr.get_queue(context_idx, 1).flush();
+    }
+
+    for (size_t idx = 0; idx < datasets.size(); idx++) {
+      dataset const& data = datasets.at(idx);
+      if (!data.output) {
+        continue;
+      }
+
+      if (!read_events.at(idx).empty()) {
+        cl::Event::waitForEvents(read_events.at(idx));
+      }
+      cl_ulong write_begin = timer.getTimeNanoseconds();
+      h5_write_buffer(out_file, data.name.c_str(), data.type, host_data.at(idx).data(), num_rows * data.row_size, data.compression);
+      transfer_records.at(idx).write_time = (timer.getTimeNanoseconds() - write_begin) / 1.0e6;
+    }
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+// return execution time in µs
+cl_ulong multi_device_executor::execute(h5_file const& config_file, h5_file const& out_file, cl_ulong repetitions, cl_ulong max_launch_range)
+{
+  cl_ulong exec_time = 0;
+
+  try {
+    buffers.assign(num_contexts, std::vector<cl::Buffer>());
+    for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+      for (size_t idx = 0; idx < datasets.size(); idx++) {
+        dataset const& data = datasets.at(idx);
+        cl_mem_flags flags = CL_MEM_READ_WRITE;
+        if (data.rw_flag == 1) {
+          flags = CL_MEM_READ_ONLY;
+        }
+        else if (data.rw_flag == 2) {
+          flags = CL_MEM_WRITE_ONLY;
+        }
+        if (!host_cpus.empty()) {
+          flags |= CL_MEM_ALLOC_HOST_PTR;
+        }
+        buffers.at(context_idx).push_back(cl::Buffer(dev_mgr.get_context(context_idx), flags, num_rows * row_bytes(idx)));
+
+        for (exec_plan::arg_target const& target : data.targets.at(context_idx)) {
+          target.kernel->setArg(target.arg_idx, buffers.at(context_idx).back());
+        }
+      }
+    }
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+    return 0;
+  }
+
+  transfer_records.assign(datasets.size(), h5_transfer_record());
+  for (size_t idx = 0; idx < datasets.size(); idx++) {
+    transfer_records.at(idx).name = datasets.at(idx).name;
+    transfer_records.at(idx).bytes = num_rows * row_bytes(idx);
+    transfer_records.at(idx).read_time = 0.0;
+    transfer_records.at(idx).upload_time = 0.0;
+    transfer_records.at(idx).download_time = 0.0;
+    transfer_records.at(idx).write_time = 0.0;
+  }
+  upload_events.assign(datasets.size(), std::vector<cl::Event>());
+  readback_events.assign(datasets.size(), std::vector<cl::Event>());
+
+  if (!upload(config_file)) {
+    return 0;
+  }
+  partition();
+
+  launch_times.assign(launches.size(), std::vector<exec_plan::launch_timing>());
+  for (std::vector<exec_plan::launch_timing>& times : launch_times) {
+    times.reserve(repetitions * num_contexts);
+  }
+
+  for (cl_ulong rep = 0; rep < repetitions; rep++) {
+    // all devices are started before waiting for any of them
+    std::vector<exec_plan> plans(num_contexts);
+    std::vector<cl_ulong> device_rows = get_device_rows();
+    for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+      if (device_rows.at(context_idx) == 0) {
+        continue;
+      }
+
+      try {
+        for (launch const& item : launches) {
+          cl_ulong range_start[3] = {item.range_start[0], item.range_start[1], item.range_start[2]};
+          cl_ulong global_range[3] = {item.global_range[0], item.global_range[1], item.global_range[2]};
+          range_start[item.split_dim] = row_begin.at(context_idx);
+          global_range[item.split_dim] = device_rows.at(context_idx);
+
+          plans.at(context_idx).add_launch(dev_mgr.getKernelbyName(context_idx, "ocl_Kernel", item.kernel_name),
+                                           &dev_mgr.get_queue(context_idx, 0), range_start, global_range, item.local_range,
+                                           max_launch_range, item.buffers);
+        }
+      }
+      catch (cl::Error err) {
+        std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+        return exec_time;
+      }
+
+      // write_only datasets are never transferred to the devices
+      for (size_t idx = 0; idx < datasets.size(); idx++) {
+        if (datasets.at(idx).rw_flag != 2) {
+          plans.at(context_idx).add_buffer_dependency(idx, transfers.at(context_idx).at(idx));
+        }
+      }
+
+      plans.at(context_idx).execute(dev_mgr, 1, true);
+    }
+
+    // the slowest device determines the time of the repetition; the throughput is averaged
+    // with the previous measurement to damp fluctuations
+    cl_ulong rep_time = 0;
+    for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+      if (device_rows.at(context_idx) == 0) {
+        continue;
+      }
+
+      cl_ulong device_time = plans.at(context_idx).finish(dev_mgr);
+      plans.at(context_idx).append_launch_times(launch_times);
+      // the plans execute a single repetition, so the last timing of each launch is the one of this device
+      for (std::vector<exec_plan::launch_timing>& times : launch_times) {
+        if (!times.empty()) {
+          times.back().context_idx = context_idx;
+        }
+      }
+      rep_time = std::max(rep_time, device_time);
+
+      // the span on the device does not depend on the number of launch parts
+      double measured = (double)device_rows.at(context_idx) / std::max<cl_ulong>(plans.at(context_idx).get_device_span(), 1);
+      double& value = throughput.at(context_idx);
+      value = (value > 0.0) ? 0.5 * (value + measured) : measured;
+    }
+    exec_time += rep_time;
+
+    // the host copies of the read_only datasets are released once their uploads have completed;
+    // nothing has waited for the uploads to devices without any rows yet
+    if (rep == 0) {
+      for (size_t idx = 0; idx < datasets.size(); idx++) {
+        if (datasets.at(idx).rw_flag != 1) {
+          continue;
+        }
+
+        try {
+          std::vector<cl::Event> uploads;
+          for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+            uploads.push_back(transfers.at(context_idx).at(idx));
+          }
+          cl::Event::waitForEvents(uploads);
+        }
+        catch (cl::Error err) {
+          std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+          return exec_time;
+        }
+        std::vector<char>().swap(host_data.at(idx));
+      }
+    }
+
+    if (rep + 1 < repetitions) {
+      if (!exchange()) {
+        return exec_time;
+      }
+      partition();
+    }
+  }
+
+  gather(out_file);
+
+  // the uploads to devices without rows have not been waited for by any kernel
+  try {
+    for (cl_uint context_idx = 0; context_idx < num_contexts; context_idx++) {
+      dev_mgr.get_queue(context_idx, 1).finish();
+    }
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+    return exec_time;
+  }
+  for (size_t idx = 0; idx < datasets.size(); idx++) {
+    transfer_records.at(idx).upload_time = dev_mgr.get_profiling_time(upload_events.at(idx)) / 1000.0;
+    transfer_records.at(idx).download_time = dev_mgr.get_profiling_time(readback_events.at(idx)) / 1000.0;
+  }
+
+  return exec_time;
+}
@@ -1,9 +1,17 @@
 /* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
 
 #include <algorithm>
+#include <cstdio>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <sstream>
+
+#if defined(_WIN32)
+#include <process.h>
+#define getpid _getpid
+#endif
 
 #include "util.hpp"
 #include "ocl_dev_mgr.hpp"
@@ -38,6 +46,17 @@ inline std::string loadProgram(std::string const& input_filename)
 }
 
 
+// 64 bit FNV-1a hash used as key of the program binary cache
+inline uint64_t hash_fnv1a(std::string const& input, uint64_t hash = 14695981039346656037ULL)
+{
+  for (unsigned char c : input) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+
 ocl_dev_mgr::ocl_dev_mgr() {
   initialize();
 }
@@ -112,13 +131,43 @@ cl_ulong ocl_dev_mgr::getDeviceList(std::vector<cl::Device>& devices)
 
 
 cl_ulong ocl_dev_mgr::init_device(cl_uint avail_device_idx)
+{
+  return add_context(available_devices.at(avail_device_idx));
+}
+
+
+// Partition the device into one sub-device per NUMA node and create a context for each of them.
+// Returns the number of sub-devices, or 0 if the device does not support the partitioning.
+cl_ulong ocl_dev_mgr::init_sub_devices(cl_uint avail_device_idx)
+{
+  std::vector<cl::Device> sub_devices;
+  try {
+    cl_device_partition_property properties[] = {CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN, CL_DEVICE_AFFINITY_DOMAIN_NUMA, 0};
+    available_devices.at(avail_device_idx).device.createSubDevices(properties, &sub_devices);
+  }
+  catch (cl::Error err) {
+    return 0;
+  }
+
+  for (cl::Device const& sub_device : sub_devices) {
+    ocl_device_info sub_device_info = available_devices.at(avail_device_idx);
+    sub_device_info.device = sub_device;
+    sub_device.getInfo(CL_DEVICE_MAX_COMPUTE_UNITS, &sub_device_info.compute_units);
+    add_context(sub_device_info);
+  }
+
+  return sub_devices.size();
+}
+
+
+cl_ulong ocl_dev_mgr::add_context(ocl_device_info const& device_info)
 {
   ocl_context tmp_context;
 
-  tmp_context.devices.push_back(available_devices.at(avail_device_idx));
+  tmp_context.devices.push_back(device_info);
 
   std::vector<cl::Device> tmp_devices;
-  tmp_devices.push_back(available_devices.at(avail_device_idx).device);
+  tmp_devices.push_back(device_info.device);
 
   cl::Context context(tmp_devices, NULL);
   tmp_context.context=context;
@@ -166,6 +215,7 @@ bool ocl_dev_mgr::add_program_str(cl_uint context_idx, std::string prog_name, st
 {
   con_list.at(context_idx).programs.push_back(cl::Program(con_list.at(context_idx).context, kernel));
   con_list.at(context_idx).prog_names.push_back(prog_name);
+  con_list.at(context_idx).prog_sources.push_back(kernel);
   con_list.at(context_idx).kernels.resize(con_list.at(context_idx).kernels.size() + 1);
   con_list.at(context_idx).kernel_names.resize(con_list.at(context_idx).kernel_names.size() + 1);
   return true;
@@ -228,18 +278,17 @@ cl_ulong ocl_dev_mgr::execute_kernel(cl::Kernel& kernel, cl::CommandQueue& queue
 }
 
 
-// return execution time in µs
+// return execution time (START to END, as for the asynchronous launches) in µs
 cl_ulong ocl_dev_mgr::execute_kernelNA(cl::Kernel& kernel, cl::CommandQueue& queue,
-                                       cl::NDRange range_start, cl::NDRange global_range, cl::NDRange local_range)
+                                       cl::NDRange range_start, cl::NDRange global_range, cl::NDRange local_range,
+                                       std::vector<cl::Event> const* wait_events, profiling_info* profile)
 {
   cl::Event event;
-  cl_ulong time_start, time_end;
+  profiling_info info = {0, 0, 0, 0};
 
   try {
-    queue.enqueueNDRangeKernel(kernel, range_start, global_range, local_range, NULL, &event);
+    queue.enqueueNDRangeKernel(kernel, range_start, global_range, local_range, wait_events, &event);
     event.wait();
-    event.getProfilingInfo(CL_PROFILING_COMMAND_END, &time_end);
-    event.getProfilingInfo(CL_PROFILING_COMMAND_SUBMIT, &time_start);
   }
   catch (cl::BuildError error) {
     std::string log = error.getBuildLog()[0].second;
@@ -249,9 +298,79 @@ cl_ulong ocl_dev_mgr::execute_kernelNA(cl::Kernel& kernel, cl::CommandQueue& que
     std::cerr << ERROR_INFO << "Exception:" << err.what() << std::endl;
   }
 
-  return (time_end - time_start) / 1000;
+  if (!get_profiling_info(event, info)) {
+    info = {0, 0, 0, 0};
+  }
+  if (profile != NULL) {
+    *profile = info;
+  }
+  return (info.end - info.start) / 1000;
+}
+
+// enqueue without waiting; the profiling information of `event` can be
+// evaluated after the queue has been finished
+void ocl_dev_mgr::enqueue_kernelNA(cl::Kernel& kernel, cl::CommandQueue& queue,
+                                   cl::NDRange range_start, cl::NDRange global_range, cl::NDRange local_range,
+                                   cl::Event* event, std::vector<cl::Event> const* wait_events)
+{
+  try {
+    queue.enqueueNDRangeKernel(kernel, range_start, global_range, local_range, wait_events, event);
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception:" << err.what() << std::endl;
+  }
+}
+
+
+// return the summed execution time of all (completed) events in µs
+cl_ulong ocl_dev_mgr::get_profiling_time(std::vector<cl::Event> const& events)
+{
+  cl_ulong exec_time = 0;
+
+  for (cl::Event const& event : events) {
+    exec_time += get_event_time(event) / 1000;
+  }
+
+  return exec_time;
+}
+
+
+// return the execution time of a (completed) event in ns; START is used instead of SUBMIT, since
+// all commands enqueued at once are submitted early and would include the commands before them
+cl_ulong ocl_dev_mgr::get_event_time(cl::Event const& event)
+{
+  cl_ulong time_start = 0, time_end = 0;
+
+  try {
+    event.getProfilingInfo(CL_PROFILING_COMMAND_END, &time_end);
+    event.getProfilingInfo(CL_PROFILING_COMMAND_START, &time_start);
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception:" << err.what() << std::endl;
+  }
+
+  return time_end - time_start;
+}
+
+
+// QUEUED to SUBMIT is the latency of the runtime, SUBMIT to START the one of the device queue
+bool ocl_dev_mgr::get_profiling_info(cl::Event const& event, profiling_info& info)
+{
+  try {
+    event.getProfilingInfo(CL_PROFILING_COMMAND_QUEUED, &info.queued);
+    event.getProfilingInfo(CL_PROFILING_COMMAND_SUBMIT, &info.submit);
+    event.getProfilingInfo(CL_PROFILING_COMMAND_START, &info.start);
+    event.getProfilingInfo(CL_PROFILING_COMMAND_END, &info.end);
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception:" << err.what() << std::endl;
+    return false;
+  }
+
+  return true;
 }
 
+
 // don't return execution time in µs
 void ocl_dev_mgr::execute_kernel_async(cl::Kernel& kernel, cl::CommandQueue& queue,
                                        cl::NDRange global_range, cl::NDRange local_range,
@@ -299,15 +418,124 @@ cl_ulong ocl_dev_mgr::compile_kernel(cl_uint context_idx, std::string const& pro
     std::cerr << ERROR_INFO << "Exception:" << err.what() << std::endl;
   }
 
-  con_list.at(context_idx).programs.at(idx).createKernels(&(con_list.at(context_idx).kernels.at(idx)));
+  return create_kernels(context_idx, idx);
+}
+
+
+// Compile kernels using the persistent binary cache in `cache_dir` and return the
+// number of compiled kernels. The cache key is a hash of the kernel source, the
+// compile options as well as the name and driver version of the device.
+cl_ulong ocl_dev_mgr::compile_kernel_cached(cl_uint context_idx, std::string const& prog_name, std::string const& options,
+                                            std::string const& cache_dir, bool& cache_hit)
+{
+  std::string compile_options = std::string(" ") + options;
+  cache_hit = false;
+
+  auto it_p = find(con_list.at(context_idx).prog_names.begin(), con_list.at(context_idx).prog_names.end(), prog_name);
+  if (it_p == con_list.at(context_idx).prog_names.end())  {
+    std::cerr << ERROR_INFO << "Program '" << prog_name << "' not found." << std::endl;
+    //TODO: Exception?
+    return 0;
+  }
+
+  int32_t idx = distance(con_list.at(context_idx).prog_names.begin(), it_p);
+  ocl_context& context = con_list.at(context_idx);
+
+  uint64_t hash = hash_fnv1a(context.prog_sources.at(idx));
+  hash = hash_fnv1a(std::string(1, '\0') + compile_options, hash);
+  std::vector<cl::Device> devices;
+  for (ocl_device_info const& device : context.devices) {
+    hash = hash_fnv1a(std::string(1, '\0') + device.name + std::string(1, '\0') + device.driver_version, hash);
+    devices.push_back(device.device);
+  }
+
+  std::stringstream cache_url;
+  cache_url << cache_dir << "/" << std::hex << std::setfill('0') << std::setw(16) << hash << ".bin";
+
+  if (fileExists(cache_url.str()) && devices.size() == 1) {
+    std::ifstream cache_file(cache_url.str().c_str(), std::ios::binary);
+    cl::Program::Binaries binaries(1, std::vector<unsigned char>((std::istreambuf_iterator<char>(cache_file)),
+                                                                 std::istreambuf_iterator<char>()));
+    try {
+      cl::Program program(context.context, devices, binaries);
+      program.build(compile_options.c_str());
+      context.programs.at(idx) = program;
+      cache_hit = true;
+      return create_kernels(context_idx, idx);
+    }
+    catch (cl::Error err) {
+      std::cerr << "Warning: Cached binary '" << cache_url.str() << "' rejected, rebuilding from source." << std::endl;
+    }
+  }
+
+  cl_ulong num_kernels = compile_kernel(context_idx, prog_name, options);
 
-  con_list.at(context_idx).kernel_names.at(idx).clear(); //make sure to clear kernel_names list
+  if (num_kernels > 0 && devices.size() == 1) {
+    try {
+      std::vector<std::vector<unsigned char>> binaries = context.programs.at(idx).getInfo<CL_PROGRAM_BINARIES>();
 
-  for (uint32_t i = 0; i < con_list.at(context_idx).kernels.at(idx).size(); i++) {
-    con_list.at(context_idx).kernel_names.at(idx).push_back(con_list.at(context_idx).kernels.at(idx).at(i).getInfo<CL_KERNEL_FUNCTION_NAME>());
+      // write to a temporary file first since several jobs may share the cache
+      std::string tmp_url = cache_url.str() + ".tmp" + std::to_string(getpid());
+      std::ofstream cache_file(tmp_url.c_str(), std::ios::binary);
+      if (cache_file.is_open() && binaries.size() == 1) {
+        cache_file.write((char const*)binaries.at(0).data(), binaries.at(0).size());
+        cache_file.close();
+        if (std::rename(tmp_url.c_str(), cache_url.str().c_str()) != 0) {
+          std::remove(tmp_url.c_str());
+        }
+      }
+      else {
+        std::cerr << "Warning: Cannot write program binary cache '" << cache_url.str() << "'." << std::endl;
+      }
+    }
+    catch (cl::Error err) {
+      std::cerr << ERROR_INFO << "Exception:" << err.what() << std::endl;
+    }
   }
 
-  return con_list.at(context_idx).kernels.at(idx).size();
+  return num_kernels;
+}
+
+
+// create all kernels of the (built) program `prog_idx` and return their number
+cl_ulong ocl_dev_mgr::create_kernels(cl_uint context_idx, size_t prog_idx)
+{
+  con_list.at(context_idx).programs.at(prog_idx).createKernels(&(con_list.at(context_idx).kernels.at(prog_idx)));
+
+  con_list.at(context_idx).kernel_names.at(prog_idx).clear(); //make sure to clear kernel_names list
+
+  for (uint32_t i = 0; i < con_list.at(context_idx).kernels.at(prog_idx).size(); i++) {
+    con_list.at(context_idx).kernel_names.at(prog_idx).push_back(con_list.at(context_idx).kernels.at(prog_idx).at(i).getInfo<CL_KERNEL_FUNCTION_NAME>());
+  }
+
+  return con_list.at(context_idx).kernels.at(prog_idx).size();
+}
+
+
+// build log of the program for all devices of the context, also if the build succeeded
+std::string ocl_dev_mgr::get_build_log(cl_uint context_idx, std::string const& prog_name)
+{
+  auto it_p = find(con_list.at(context_idx).prog_names.begin(), con_list.at(context_idx).prog_names.end(), prog_name);
+  if (it_p == con_list.at(context_idx).prog_names.end())  {
+    std::cerr << ERROR_INFO << "Program '" << prog_name << "' not found." << std::endl;
+    return std::string();
+  }
+
+  int32_t idx = distance(con_list.at(context_idx).prog_names.begin(), it_p);
+
+  std::string log;
+  try {
+    for (ocl_device_info const& device : con_list.at(context_idx).devices) {
+      std::string device_log;
+      con_list.at(context_idx).programs.at(idx).getBuildInfo(device.device, CL_PROGRAM_BUILD_LOG, &device_log);
+      log += device_log;
+    }
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception:" << err.what() << std::endl;
+  }
+
+  return log;
 }
 
 
@@ -330,6 +558,35 @@ cl_ulong ocl_dev_mgr::get_kernel_names(cl_uint context_idx, std::string const& p
 }
 
 
+// return the number of arguments of `kernel`; the names are only available if the
+// program has been built with `-cl-kernel-arg-info`, `arg_names` is empty otherwise
+cl_uint ocl_dev_mgr::get_kernel_arg_names(cl::Kernel& kernel, std::vector<std::string>& arg_names)
+{
+  cl_uint num_args = 0;
+  arg_names.clear();
+
+  try {
+    kernel.getInfo(CL_KERNEL_NUM_ARGS, &num_args);
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception:" << err.what() << std::endl;
+    return 0;
+  }
+
+  try {
+    for (cl_uint arg_idx = 0; arg_idx < num_args; arg_idx++) {
+      arg_names.push_back(kernel.getArgInfo<CL_KERNEL_ARG_NAME>(arg_idx));
+    }
+  }
+  catch (cl::Error err) {
+    // CL_KERNEL_ARG_INFO_NOT_AVAILABLE
+    arg_names.clear();
+  }
+
+  return num_args;
+}
+
+
 void ocl_dev_mgr::initialize()
 {
   std::vector<cl::Device> tmp_devices;
@@ -345,14 +602,18 @@ void ocl_dev_mgr::initialize()
 
     available_devices.at(i).device.getInfo(CL_DEVICE_GLOBAL_MEM_SIZE,          &available_devices.at(i).max_mem);
     available_devices.at(i).device.getInfo(CL_DEVICE_MAX_MEM_ALLOC_SIZE,       &available_devices.at(i).max_mem_alloc);
+    available_devices.at(i).device.getInfo(CL_DEVICE_LOCAL_MEM_SIZE,           &available_devices.at(i).local_mem);
     available_devices.at(i).device.getInfo(CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS, &available_devices.at(i).lw_dim);
     available_devices.at(i).device.getInfo(CL_DEVICE_MAX_WORK_GROUP_SIZE,      &available_devices.at(i).wg_size);
     available_devices.at(i).device.getInfo(CL_DEVICE_MAX_WORK_ITEM_SIZES,      &tmp_size);
     available_devices.at(i).lw_size = tmp_size.at(0);
     available_devices.at(i).device.getInfo(CL_DEVICE_NAME,                     &available_devices.at(i).name);
     available_devices.at(i).device.getInfo(CL_DEVICE_VERSION,                  &available_devices.at(i).ocl_version);
+    available_devices.at(i).device.getInfo(CL_DRIVER_VERSION,                  &available_devices.at(i).driver_version);
     available_devices.at(i).device.getInfo(CL_DEVICE_TYPE,                     &available_devices.at(i).type);
     available_devices.at(i).device.getInfo(CL_DEVICE_MAX_COMPUTE_UNITS,        &available_devices.at(i).compute_units);
+    available_devices.at(i).device.getInfo(CL_DEVICE_ADDRESS_BITS,             &available_devices.at(i).address_bits);
+    available_devices.at(i).device.getInfo(CL_DEVICE_HOST_UNIFIED_MEMORY,      &available_devices.at(i).host_unified);
   }
 }
 
@@ -0,0 +1,228 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include "tiling.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "util.hpp"
+
+
+tiled_executor::tiled_executor(ocl_dev_mgr& dev_mgr, cl_uint context_idx, cl_ulong num_rows, cl_ulong tile_rows, cl_ulong halo)
+  : dev_mgr(dev_mgr), context_idx(context_idx), num_rows(num_rows), tile_rows(std::max<cl_ulong>(tile_rows, 1)), halo(halo)
+{
+}
+
+
+// the buffers of the tile `tile_idx % 2` are free again, since the kernels of the tile two
+// steps before have been waited for in `download`
+bool tiled_executor::upload(h5_file const& config_file, size_t tile_idx)
+{
+  tile& current = tiles[tile_idx % 2];
+  current.row_start = tile_idx * tile_rows;
+  current.row_end = std::min(num_rows, current.row_start + tile_rows);
+  current.buffer_start = current.row_start - std::min(current.row_start, halo);
+  current.buffer_end = std::min(num_rows, current.row_end + halo);
+  current.upload_events.assign(datasets.size(), cl::Event());
+
+  cl::CommandQueue& queue = dev_mgr.get_queue(context_idx, 1);
+
+  for (size_t idx = 0; idx < datasets.size(); idx++) {
+    dataset const& data = datasets.at(idx);
+    if (data.rw_flag == 2) {
+      continue;
+    }
+
+    size_t var_size = (current.buffer_end - current.buffer_start) * data.row_size * h5_type_size(data.type);
+    try {
+      void* mapped_data = queue.enqueueMapBuffer(buffers[tile_idx % 2].at(idx), CL_TRUE, CL_MAP_WRITE_INVALIDATE_REGION, 0, var_size);
+      cl_ulong read_begin = timer.getTimeNanoseconds();
+      bool success = h5_read_rows(config_file, data.name.c_str(), data.type, current.buffer_start,
+                                  current.buffer_end - current.buffer_start, mapped_data);
+      transfer_records.at(idx).read_time += (timer.getTimeNanoseconds() - read_begin) / 1.0e6;
+      queue.enqueueUnmapMemObject(buffers[tile_idx % 2].at(idx), mapped_data, NULL, &current.upload_events.at(idx));
+      upload_events.at(idx).push_back(current.upload_events.at(idx));
+      queue.flush();
+      if (!success) {
+        return false;
+      }
+    }
+    catch (cl::Error err) {
+      std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+// the arguments are captured when the launches are enqueued, hence the kernels of the previous
+// tile are not affected by binding the buffers of this tile
+void tiled_executor::enqueue(size_t tile_idx, cl_ulong repetitions, cl_ulong max_launch_range)
+{
+  tile& current = tiles[tile_idx % 2];
+  current.plan = exec_plan();
+
+  try {
+    for (size_t idx = 0; idx < datasets.size(); idx++) {
+      for (exec_plan::arg_target const& target : datasets.at(idx).targets) {
+        target.kernel->setArg(target.arg_idx, buffers[tile_idx % 2].at(idx));
+      }
+    }
+
+    for (launch const& item : launches) {
+      cl_ulong range_start[3] = {item.range_start[0], item.range_start[1], item.range_start[2]};
+      cl_ulong global_range[3] = {item.global_range[0], item.global_range[1], item.global_range[2]};
+
+      // With an argument `tile_offset`, the global ids are the ones of the whole dataset and the
+      // kernel subtracts the first row in the buffers. Otherwise, the ids refer to the buffers.
+      if (item.tile_offset_idx >= 0) {
+        cl_ulong tile_offset = current.buffer_start;
+        item.kernel->setArg(item.tile_offset_idx, tile_offset);
+        range_start[item.tile_dim] = current.row_start;
+      }
+      else {
+        range_start[item.tile_dim] = current.row_start - current.buffer_start;
+      }
+      global_range[item.tile_dim] = current.row_end - current.row_start;
+
+      current.plan.add_launch(item.kernel, &dev_mgr.get_queue(context_idx, 0), range_start, global_range, item.local_range,
+                              max_launch_range, item.buffers);
+    }
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+  }
+
+  for (size_t idx = 0; idx < datasets.size(); idx++) {
+    if (datasets.at(idx).rw_flag != 2) {
+      current.plan.add_buffer_dependency(idx, current.upload_events.at(idx));
+    }
+  }
+
+  current.plan.execute(dev_mgr, repetitions, true);
+}
+
+
+cl_ulong tiled_executor::download(h5_file const& out_file, size_t tile_idx)
+{
+  tile& current = tiles[tile_idx % 2];
+  cl::CommandQueue& queue = dev_mgr.get_queue(context_idx, 1);
+
+  for (size_t idx = 0; idx < datasets.size(); idx++) {
+    dataset const& data = datasets.at(idx);
+    if (!data.output) {
+      continue;
+    }
+
+    size_t element_size = data.row_size * h5_type_size(data.type);
+    size_t offset = (current.row_start - current.buffer_start) * element_size;
+    size_t var_size = (current.row_end - current.row_start) * element_size;
+
+    try {
+      std::vector<cl::Event> wait_events;
+      current.plan.get_buffer_events(idx, wait_events);
+      readback_events.at(idx).push_back(cl::Event());
+      void* mapped_data = queue.enqueueMapBuffer(buffers[tile_idx % 2].at(idx), CL_TRUE, CL_MAP_READ, offset, var_size,
+                                                 wait_events.empty() ? NULL : &wait_events, &readback_events.at(idx).back());
+      cl_ulong write_begin = timer.getTimeNanoseconds();
+      h5_write_rows(out_file, data.name.c_str(), data.type, current.row_start * data.row_size,
+                    (current.row_end - current.row_start) * data.row_size, mapped_data);
+      transfer_records.at(idx).write_time += (timer.getTimeNanoseconds() - write_begin) / 1.0e6;
+      queue.enqueueUnmapMemObject(buffers[tile_idx % 2].at(idx), mapped_data);
+    }
+    catch (cl::Error err) {
+      std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+    }
+  }
+
+  cl_ulong exec_time = current.plan.finish(dev_mgr);
+  current.plan.append_launch_times(launch_times);
+
+  return exec_time;
+}
+
+
+// return execution time in µs
+cl_ulong tiled_executor::execute(h5_file const& config_file, h5_file const& out_file, cl_ulong repetitions, cl_ulong max_launch_range)
+{
+  cl_ulong exec_time = 0;
+  cl_ulong buffer_rows = std::min(num_rows, tile_rows + 2 * halo);
+
+  launch_times.assign(launches.size(), std::vector<exec_plan::launch_timing>());
+  for (std::vector<exec_plan::launch_timing>& times : launch_times) {
+    times.reserve(repetitions * num_tiles());
+  }
+
+  transfer_records.assign(datasets.size(), h5_transfer_record());
+  for (size_t idx = 0; idx < datasets.size(); idx++) {
+    transfer_records.at(idx).name = datasets.at(idx).name;
+    transfer_records.at(idx).bytes = num_rows * datasets.at(idx).row_size * h5_type_size(datasets.at(idx).type);
+    transfer_records.at(idx).read_time = 0.0;
+    transfer_records.at(idx).upload_time = 0.0;
+    transfer_records.at(idx).download_time = 0.0;
+    transfer_records.at(idx).write_time = 0.0;
+  }
+  upload_events.assign(datasets.size(), std::vector<cl::Event>());
+  readback_events.assign(datasets.size(), std::vector<cl::Event>());
+
+  try {
+    for (cl_uint set = 0; set < 2; set++) {
+      buffers[set].clear();
+      for (dataset const& data : datasets) {
+        cl_mem_flags flags = CL_MEM_READ_WRITE;
+        if (data.rw_flag == 1) {
+          flags = CL_MEM_READ_ONLY;
+        }
+        else if (data.rw_flag == 2) {
+          flags = CL_MEM_WRITE_ONLY;
+        }
+        size_t var_size = buffer_rows * data.row_size * h5_type_size(data.type);
+        buffers[set].push_back(cl::Buffer(dev_mgr.get_context(context_idx), flags | CL_MEM_ALLOC_HOST_PTR, var_size));
+      }
+    }
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+    return 0;
+  }
+
+  // the output datasets are written in parts
+  for (dataset const& data : datasets) {
+    if (data.output) {
+      h5_compression compression = data.compression;
+      if (compression.chunk.empty()) {
+        compression.chunk.push_back(tile_rows * data.row_size);
+      }
+      h5_create_buffer(out_file, data.name.c_str(), data.type, num_rows * data.row_size, compression);
+    }
+  }
+
+  // while the kernels process tile i, tile i+1 is read and uploaded and tile i-1 is written
+  size_t tiles_total = num_tiles();
+  if (tiles_total == 0 || !upload(config_file, 0)) {
+    return 0;
+  }
+  enqueue(0, repetitions, max_launch_range);
+
+  for (size_t tile_idx = 1; tile_idx < tiles_total; tile_idx++) {
+    if (!upload(config_file, tile_idx)) {
+      exec_time += download(out_file, tile_idx - 1);
+      return exec_time;
+    }
+    enqueue(tile_idx, repetitions, max_launch_range);
+    exec_time += download(out_file, tile_idx - 1);
+  }
+  exec_time += download(out_file, tiles_total - 1);
+
+  dev_mgr.get_queue(context_idx, 1).finish();
+
+  // the transfers of all tiles have completed, their device times are summed
+  for (size_t idx = 0; idx < datasets.size(); idx++) {
+    transfer_records.at(idx).upload_time = dev_mgr.get_profiling_time(upload_events.at(idx)) / 1000.0;
+    transfer_records.at(idx).download_time = dev_mgr.get_profiling_time(readback_events.at(idx)) / 1000.0;
+  }
+
+  return exec_time;
+}
@@ -0,0 +1,205 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "trace.hpp"
+#include "util.hpp"
+
+
+// JSON string literal of `value`, which ends at a null character (as the dataset names do)
+static std::string json_string(std::string const& value)
+{
+  std::ostringstream result;
+  result << '"';
+  for (char c : value) {
+    if (c == '\0') {
+      break;
+    }
+    switch (c) {
+      case '"':  result << "\\\""; break;
+      case '\\': result << "\\\\"; break;
+      case '\n': result << "\\n"; break;
+      case '\t': result << "\\t"; break;
+      default:
+        if ((unsigned char)c < 0x20) {
+          result << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec;
+        }
+        else {
+          result << c;
+        }
+    }
+  }
+  result << '"';
+  return result.str();
+}
+
+
+void trace_writer::add_host_stage(std::string const& name, std::string const& category, cl_ulong begin, cl_ulong end)
+{
+  event item = event();
+  item.name = name;
+  item.category = category;
+  item.phase = 'X';
+  item.time = begin;
+  item.duration = end > begin ? end - begin : 0;
+  events.push_back(item);
+}
+
+void trace_writer::add_device_command(cl_uint context_idx, cl_uint queue_idx, std::string const& name, std::string const& category,
+                                      ocl_dev_mgr::profiling_info const& profile)
+{
+  event item = event();
+  item.name = name;
+  item.category = category;
+  item.phase = 'X';
+  item.pid = context_idx + 1;
+  item.tid = queue_idx;
+  item.time = profile.start;
+  item.duration = profile.end > profile.start ? profile.end - profile.start : 0;
+  item.device_time = true;
+  item.profile = profile;
+  events.push_back(item);
+}
+
+void trace_writer::add_counter(std::string const& name, cl_ulong time, double value)
+{
+  event item = event();
+  item.name = name;
+  item.category = "sensor";
+  item.phase = 'C';
+  item.time = time;
+  item.value = value;
+  events.push_back(item);
+}
+
+void trace_writer::set_device_name(cl_uint context_idx, std::string const& name)
+{
+  if (device_names.size() <= context_idx) {
+    device_names.resize(context_idx + 1);
+  }
+  device_names.at(context_idx) = name;
+}
+
+
+// A blocking write of a few bytes is used instead of a marker, since the profiling information
+// of markers is not reliable on all implementations. The device timestamp at the end of the
+// write is assumed to be in the middle of the host interval; the shortest of several intervals
+// is used.
+bool trace_writer::calibrate(ocl_dev_mgr& dev_mgr, cl_uint context_idx, cl_uint queue_idx)
+{
+  calibration best = {0, 0.0};
+  cl_ulong best_interval = ~(cl_ulong)0;
+
+  try {
+    cl::CommandQueue& queue = dev_mgr.get_queue(context_idx, queue_idx);
+    cl::Buffer buffer(dev_mgr.get_context(context_idx), CL_MEM_READ_WRITE, sizeof(cl_uint));
+    cl_uint value = 0;
+    queue.finish();
+
+    for (int i = 0; i < 5; i++) {
+      cl::Event write_event;
+      cl_ulong before = now();
+      queue.enqueueWriteBuffer(buffer, CL_TRUE, 0, sizeof(cl_uint), &value, NULL, &write_event);
+      cl_ulong after = now();
+
+      ocl_dev_mgr::profiling_info profile;
+      if (!dev_mgr.get_profiling_info(write_event, profile) || profile.end == 0) {
+        return false;
+      }
+      if (after - before < best_interval) {
+        best_interval = after - before;
+        best.device_time = profile.end;
+        best.offset = (before + after) / 2.0 - (double)profile.end;
+      }
+    }
+  }
+  catch (cl::Error err) {
+    std::cerr << ERROR_INFO << "Exception: " << err.what() << std::endl;
+    return false;
+  }
+
+  if (calibrations.size() <= context_idx) {
+    calibrations.resize(context_idx + 1);
+  }
+  std::vector<calibration>& context_calibrations = calibrations.at(context_idx);
+  context_calibrations.push_back(best);
+  std::sort(context_calibrations.begin(), context_calibrations.end(),
+            [](calibration const& a, calibration const& b) { return a.device_time < b.device_time; });
+  return true;
+}
+
+double trace_writer::host_time(cl_uint context_idx, cl_ulong device_time) const
+{
+  if (context_idx >= calibrations.size() || calibrations.at(context_idx).empty()) {
+    return (double)device_time;
+  }
+
+  std::vector<calibration> const& context_calibrations = calibrations.at(context_idx);
+  if (device_time <= context_calibrations.front().device_time) {
+    return device_time + context_calibrations.front().offset;
+  }
+  for (size_t idx = 1; idx < context_calibrations.size(); idx++) {
+    calibration const& a = context_calibrations.at(idx - 1);
+    calibration const& b = context_calibrations.at(idx);
+    if (device_time < b.device_time) {
+      double weight = (double)(device_time - a.device_time) / (double)(b.device_time - a.device_time);
+      return device_time + (1.0 - weight) * a.offset + weight * b.offset;
+    }
+  }
+  return device_time + context_calibrations.back().offset;
+}
+
+
+// The timestamps are written in µs with ns resolution, as required by the trace event format.
+bool trace_writer::write(std::string const& filename) const
+{
+  std::ofstream file(filename.c_str());
+  if (!file.is_open()) {
+    std::cerr << ERROR_INFO << "Cannot open trace file '" << filename << "'." << std::endl;
+    return false;
+  }
+  file << std::fixed << std::setprecision(3);
+
+  file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+  file << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, \"args\": {\"name\": \"Host\"}}";
+  for (cl_uint context_idx = 0; context_idx < std::max(device_names.size(), calibrations.size()); context_idx++) {
+    std::string name = "Device " + std::to_string(context_idx);
+    if (context_idx < device_names.size() && !device_names.at(context_idx).empty()) {
+      name += ": " + device_names.at(context_idx);
+    }
+    if (context_idx >= calibrations.size() || calibrations.at(context_idx).empty()) {
+      name += " (device clock)";
+    }
+    file << "," << std::endl << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << context_idx + 1
+         << ", \"args\": {\"name\": " << json_string(name) << "}}";
+    file << "," << std::endl << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << context_idx + 1
+         << ", \"tid\": 0, \"args\": {\"name\": \"Compute queue\"}}";
+    file << "," << std::endl << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << context_idx + 1
+         << ", \"tid\": 1, \"args\": {\"name\": \"Copy queue\"}}";
+  }
+
+  for (event const& item : events) {
+    file << "," << std::endl << "{\"name\": " << json_string(item.name) << ", \"cat\": " << json_string(item.category)
+         << ", \"ph\": \"" << item.phase << "\", \"pid\": " << item.pid << ", \"tid\": " << item.tid;
+
+    if (item.phase == 'C') {
+      file << ", \"ts\": " << item.time / 1000.0 << ", \"args\": {\"value\": " << item.value << "}}";
+    }
+    else if (item.device_time) {
+      file << ", \"ts\": " << host_time(item.pid - 1, item.time) / 1000.0 << ", \"dur\": " << item.duration / 1000.0
+           << ", \"args\": {\"queued\": " << host_time(item.pid - 1, item.profile.queued) / 1000.0
+           << ", \"submit\": " << host_time(item.pid - 1, item.profile.submit) / 1000.0
+           << ", \"queue_latency_us\": " << (item.profile.start - item.profile.queued) / 1000.0 << "}}";
+    }
+    else {
+      file << ", \"ts\": " << item.time / 1000.0 << ", \"dur\": " << item.duration / 1000.0 << "}";
+    }
+  }
+  file << std::endl << "]}" << std::endl;
+
+  return file.good();
+}
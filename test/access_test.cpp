@@ -0,0 +1,101 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "opencl_include.hpp"
+#include "util.hpp"
+#include "hdf5_io.hpp"
+
+
+using namespace std;
+
+
+int main(void)
+{
+  constexpr int LENGTH = 32;
+
+  string filename{"access_test.h5"};
+
+  h5_file config_file(filename, h5_file::truncate);
+
+  // kernel
+  string kernel_url("twice_kernel.cl");
+  ofstream kernel_file;
+  kernel_file.open(kernel_url);
+  kernel_file << "\n\
+kernel void twice(global int const* input, global int* output)\n\
+{\n\
+  const int gid = get_global_id(0);\n\
+  output[gid] = 2 * input[gid];\n\
+}\n\
+" << endl;
+  kernel_file.close();
+
+  h5_write_string(config_file, "Kernel_Settings", "");
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
+  vector<string> kernels(1, string("twice"));
+  h5_write_strings(config_file, "Kernels", kernels);
+
+  // ranges
+  cl_int tmp_range[3];
+  tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_int>(config_file, "Global_Range", tmp_range, 3);
+
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_int>(config_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_int>(config_file, "Range_Start", tmp_range, 3);
+
+  // data; the buffers are bound in alphabetical order of the datasets
+  vector<cl_int> input(LENGTH);
+  vector<cl_int> output(LENGTH, -1);
+  for (cl_int i = 0; i < LENGTH; ++i) {
+    input.at(i) = i;
+  }
+
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<cl_int>(config_file, "Data/a_input", &input[0], LENGTH);
+  h5_write_attribute_string(config_file, "Data/a_input", "access", "read_only");
+  h5_write_buffer<cl_int>(config_file, "Data/b_output", &output[0], LENGTH);
+  h5_write_attribute_string(config_file, "Data/b_output", "access", "write_only");
+  config_file.close();
+
+
+  // call toolkitICL
+  string command("toolkitICL -c ");
+  command.append(filename);
+  int retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+
+  // check result
+  string out_filename("out_");
+  out_filename.append(filename);
+  vector<cl_int> input_test(LENGTH);
+  vector<cl_int> output_test(LENGTH);
+
+  if (!fileExists(out_filename)) {
+    cerr << "Error: File " << out_filename << " not found." << endl;
+    return 1;
+  }
+  h5_file out_file(out_filename, h5_file::read_only);
+
+  h5_read_buffer<cl_int>(out_file, "Data/a_input", &input_test[0]);
+  h5_read_buffer<cl_int>(out_file, "Data/b_output", &output_test[0]);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    if (input_test[idx] != input[idx]) {
+      cerr << "Error: Result 'a_input[" << idx << "] == " << input_test[idx] << "' is not as expected [" << input[idx] << "]." << endl;
+      return 1;
+    }
+    if (output_test[idx] != 2 * input[idx]) {
+      cerr << "Error: Result 'b_output[" << idx << "] == " << output_test[idx] << "' is not as expected [" << 2 * input[idx] << "]." << endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
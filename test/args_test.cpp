@@ -0,0 +1,106 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "opencl_include.hpp"
+#include "util.hpp"
+#include "hdf5_io.hpp"
+
+
+using namespace std;
+
+
+int main(void)
+{
+  constexpr int LENGTH = 32;
+
+  string filename{"args_test.h5"};
+
+  h5_file config_file(filename, h5_file::truncate);
+
+  // kernel
+  string kernel_url("scale_kernel.cl");
+  ofstream kernel_file;
+  kernel_file.open(kernel_url);
+  kernel_file << "\n\
+kernel void scale(int factor, global int* values, int4 offset)\n\
+{\n\
+  const int gid = get_global_id(0);\n\
+  values[gid] = factor * values[gid] + offset.s0 + offset.s3;\n\
+}\n\
+" << endl;
+  kernel_file.close();
+
+  h5_write_string(config_file, "Kernel_Settings", "");
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
+  vector<string> kernels(1, string("scale"));
+  h5_write_strings(config_file, "Kernels", kernels);
+
+  // ranges
+  cl_int tmp_range[3];
+  tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_int>(config_file, "Global_Range", tmp_range, 3);
+
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_int>(config_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_int>(config_file, "Range_Start", tmp_range, 3);
+
+  // data
+  vector<cl_int> values(LENGTH);
+  for (cl_int i = 0; i < LENGTH; ++i) {
+    values.at(i) = i;
+  }
+
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<cl_int>(config_file, "Data/values", &values[0], LENGTH);
+
+  // by-value arguments; `factor` is bound explicitly to the first argument
+  cl_int factor = 3;
+  cl_int offset[4] = {10, 20, 30, 40};
+  cl_int factor_idx = 0;
+  h5_create_dir(config_file, "/Args");
+  h5_write_single<cl_int>(config_file, "Args/factor", factor);
+  h5_write_attribute<cl_int>(config_file, "Args/factor", "arg_index", &factor_idx, 1);
+  h5_write_buffer<cl_int>(config_file, "Args/offset", offset, 4);
+  config_file.close();
+
+
+  // call toolkitICL
+  string command("toolkitICL -c ");
+  command.append(filename);
+  int retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+
+  // check result
+  string out_filename("out_");
+  out_filename.append(filename);
+  vector<cl_int> values_test(LENGTH);
+
+  if (!fileExists(out_filename)) {
+    cerr << "Error: File " << out_filename << " not found." << endl;
+    return 1;
+  }
+  h5_file out_file(out_filename, h5_file::read_only);
+
+  h5_read_buffer<cl_int>(out_file, "Data/values", &values_test[0]);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    cl_int expected = factor * values[idx] + offset[0] + offset[3];
+    if (values_test[idx] != expected) {
+      cerr << "Error: Result 'values[" << idx << "] == " << values_test[idx] << "' is not as expected [" << expected << "]." << endl;
+      return 1;
+    }
+  }
+
+  if (h5_read_single<cl_int>(out_file, "Args/factor") != factor) {
+    cerr << "Error: Argument 'factor' not stored in the output file." << endl;
+    return 1;
+  }
+
+  return 0;
+}
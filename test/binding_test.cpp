@@ -0,0 +1,108 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "opencl_include.hpp"
+#include "util.hpp"
+#include "hdf5_io.hpp"
+
+
+using namespace std;
+
+
+int main(void)
+{
+  constexpr int LENGTH = 32;
+
+  string filename{"binding_test.h5"};
+
+  h5_file config_file(filename, h5_file::truncate);
+
+  // kernel; the order of the arguments differs from the order of the datasets
+  string kernel_url("increment_kernel.cl");
+  ofstream kernel_file;
+  kernel_file.open(kernel_url);
+  kernel_file << "\n\
+kernel void increment(global int* b, global int const* a)\n\
+{\n\
+  const int gid = get_global_id(0);\n\
+  b[gid] = a[gid] + 1;\n\
+}\n\
+" << endl;
+  kernel_file.close();
+
+  h5_write_string(config_file, "Kernel_Settings", "");
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
+  vector<string> kernels(1, string("increment"));
+  h5_write_strings(config_file, "Kernels", kernels);
+
+  // ranges
+  cl_int tmp_range[3];
+  tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_int>(config_file, "Global_Range", tmp_range, 3);
+
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_int>(config_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_int>(config_file, "Range_Start", tmp_range, 3);
+
+  // data; `unused` is not referenced by any kernel and copied unchanged
+  vector<cl_int> a(LENGTH);
+  vector<cl_int> b(LENGTH, 0);
+  vector<cl_int> unused(LENGTH);
+  for (cl_int i = 0; i < LENGTH; ++i) {
+    a.at(i) = i;
+    unused.at(i) = -i;
+  }
+
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<cl_int>(config_file, "Data/a", &a[0], LENGTH);
+  h5_write_buffer<cl_int>(config_file, "Data/b", &b[0], LENGTH);
+  h5_write_buffer<cl_int>(config_file, "Data/unused", &unused[0], LENGTH);
+  config_file.close();
+
+
+  // call toolkitICL
+  string command("toolkitICL -c ");
+  command.append(filename);
+  int retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+
+  // check result
+  string out_filename("out_");
+  out_filename.append(filename);
+  vector<cl_int> a_test(LENGTH);
+  vector<cl_int> b_test(LENGTH);
+  vector<cl_int> unused_test(LENGTH);
+
+  if (!fileExists(out_filename)) {
+    cerr << "Error: File " << out_filename << " not found." << endl;
+    return 1;
+  }
+  h5_file out_file(out_filename, h5_file::read_only);
+
+  h5_read_buffer<cl_int>(out_file, "Data/a", &a_test[0]);
+  h5_read_buffer<cl_int>(out_file, "Data/b", &b_test[0]);
+  h5_read_buffer<cl_int>(out_file, "Data/unused", &unused_test[0]);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    if (a_test[idx] != a[idx]) {
+      cerr << "Error: Result 'a[" << idx << "] == " << a_test[idx] << "' is not as expected [" << a[idx] << "]." << endl;
+      return 1;
+    }
+    if (b_test[idx] != a[idx] + 1) {
+      cerr << "Error: Result 'b[" << idx << "] == " << b_test[idx] << "' is not as expected [" << a[idx] + 1 << "]." << endl;
+      return 1;
+    }
+    if (unused_test[idx] != unused[idx]) {
+      cerr << "Error: Result 'unused[" << idx << "] == " << unused_test[idx] << "' is not as expected [" << unused[idx] << "]." << endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,205 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "opencl_include.hpp"
+#include "util.hpp"
+#include "hdf5_io.hpp"
+
+
+using namespace std;
+
+
+int main(void)
+{
+  constexpr int LENGTH = 32;
+
+  string filename{"compression_test.h5"};
+
+  h5_file config_file(filename, h5_file::truncate);
+
+  // kernel
+  string kernel_url("add_one_kernel.cl");
+  ofstream kernel_file;
+  kernel_file.open(kernel_url);
+  kernel_file << "\n\
+#ifdef cl_khr_fp64\n\
+  #pragma OPENCL EXTENSION cl_khr_fp64 : enable\n\
+#else\n\
+  #error \"IEEE-754 double precision not supported by OpenCL implementation.\"\n\
+#endif\n\
+\n\
+kernel void add_one(global REAL* values)\n\
+{\n\
+  const int gid = get_global_id(0);\n\
+  values[gid] += 1;\n\
+}\n\
+" << endl;
+  kernel_file.close();
+
+  h5_write_string(config_file, "Kernel_Settings", "-DREAL=ulong");
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
+  vector<string> kernels(1, string("add_one"));
+  h5_write_strings(config_file, "Kernels", kernels);
+  cl_ulong kernel_repetitions = 5;
+  h5_write_single<cl_ulong>(config_file, "Kernel_Repetitions", kernel_repetitions);
+
+  // ranges
+  cl_int tmp_range[3];
+  tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_int>(config_file, "Global_Range", tmp_range, 3);
+
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_int>(config_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_int>(config_file, "Range_Start", tmp_range, 3);
+
+  // data
+  vector<cl_ulong> values(LENGTH);
+  for (cl_ulong i = 0; i < LENGTH; ++i) {
+    values.at(i) = i;
+  }
+
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<cl_ulong>(config_file, "Data/values", &values[0], LENGTH);
+
+  // compression policy for the whole run and a different one for `Data/values`
+  h5_write_string(config_file, "Compression", "shuffle_deflate");
+  h5_write_single<cl_int>(config_file, "Compression_Level", 4);
+  h5_write_attribute_string(config_file, "Data/values", "compression", "none");
+  cl_ulong chunk = 8;
+  h5_write_attribute<cl_ulong>(config_file, "Data/values", "chunk", &chunk, 1);
+  config_file.close();
+
+
+  // call toolkitICL
+  string command("toolkitICL -c ");
+  command.append(filename);
+  int retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+
+  // check result
+  string out_filename("out_");
+  out_filename.append(filename);
+  vector<cl_ulong> values_test(LENGTH);
+
+  if (!fileExists(out_filename)) {
+    cerr << "Error: File " << out_filename << " not found." << endl;
+    return 1;
+  }
+  h5_file out_file(out_filename, h5_file::read_only);
+
+  h5_read_buffer<cl_ulong>(out_file, "Data/values", &values_test[0]);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    if (values_test[idx] != values[idx] + kernel_repetitions) {
+      cerr << "Error: Result 'values[" << idx << "] == " << values_test[idx] << "' is not as expected [" << values[idx] + kernel_repetitions << "]." << endl;
+      return 1;
+    }
+  }
+
+  string compression_name;
+  h5_read_string(out_file, "Compression", compression_name);
+  h5_compression::filter_type filter;
+  if (!h5_parse_compression(compression_name, filter) || filter != h5_compression::shuffle_deflate) {
+    cerr << "Error: Compression '" << compression_name << "' is not as expected." << endl;
+    return 1;
+  }
+  if (h5_read_single<cl_int>(out_file, "Compression_Level") != 4) {
+    cerr << "Error: Compression_Level is not as expected." << endl;
+    return 1;
+  }
+
+  h5_compression data_compression;
+  h5_read_compression_attributes(out_file, "Data/values", data_compression);
+  if (data_compression.filter != h5_compression::none || data_compression.level != 4 ||
+      data_compression.chunk.size() != 1 || data_compression.chunk.at(0) != chunk) {
+    cerr << "Error: Compression of 'Data/values' is not as expected." << endl;
+    return 1;
+  }
+  out_file.close();
+
+
+  // round trip through the parallel chunk compression: several chunks with a partial last one,
+  // compressed by several threads and read back through the HDF5 filter pipeline
+  constexpr int PARALLEL_LENGTH = 1000;
+  constexpr cl_ulong PARALLEL_CHUNK = 64;
+  string parallel_filename{"compression_parallel_test.h5"};
+
+  h5_file parallel_config(parallel_filename, h5_file::truncate);
+  h5_write_string(parallel_config, "Kernel_Settings", "-DREAL=ulong");
+  h5_write_string(parallel_config, "Kernel_URL", kernel_url.c_str());
+  h5_write_strings(parallel_config, "Kernels", kernels);
+  h5_write_single<cl_ulong>(parallel_config, "Kernel_Repetitions", kernel_repetitions);
+
+  tmp_range[0] = PARALLEL_LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_int>(parallel_config, "Global_Range", tmp_range, 3);
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_int>(parallel_config, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_int>(parallel_config, "Range_Start", tmp_range, 3);
+
+  vector<cl_ulong> parallel_values(PARALLEL_LENGTH);
+  for (cl_ulong i = 0; i < PARALLEL_LENGTH; ++i) {
+    parallel_values.at(i) = i * i;
+  }
+  h5_create_dir(parallel_config, "/Data");
+  h5_write_buffer<cl_ulong>(parallel_config, "Data/values", &parallel_values[0], PARALLEL_LENGTH);
+  h5_write_string(parallel_config, "Compression", "shuffle_deflate");
+  h5_write_single<cl_int>(parallel_config, "Compression_Level", 6);
+  h5_write_attribute<cl_ulong>(parallel_config, "Data/values", "chunk", &PARALLEL_CHUNK, 1);
+  parallel_config.close();
+
+  command = string("toolkitICL -ct 4 -c ");
+  command.append(parallel_filename);
+  retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+  string parallel_out_filename("out_");
+  parallel_out_filename.append(parallel_filename);
+  if (!fileExists(parallel_out_filename)) {
+    cerr << "Error: File " << parallel_out_filename << " not found." << endl;
+    return 1;
+  }
+  h5_file parallel_out(parallel_out_filename, h5_file::read_only);
+
+  // the dataset is stored with the shuffle and deflate filters
+  hid_t dataset = H5Dopen(parallel_out.id(), "Data/values", H5P_DEFAULT);
+  hid_t dcpl = H5Dget_create_plist(dataset);
+  int num_filters = H5Pget_nfilters(dcpl);
+  H5Pclose(dcpl);
+  H5Dclose(dataset);
+  if (num_filters != 2) {
+    cerr << "Error: 'Data/values' is stored with " << num_filters << " filters instead of shuffle and deflate." << endl;
+    return 1;
+  }
+
+  vector<cl_ulong> parallel_test(PARALLEL_LENGTH);
+  h5_read_buffer<cl_ulong>(parallel_out, "Data/values", &parallel_test[0]);
+  for (size_t idx = 0; idx < PARALLEL_LENGTH; ++idx) {
+    if (parallel_test[idx] != parallel_values[idx] + kernel_repetitions) {
+      cerr << "Error: Result 'values[" << idx << "] == " << parallel_test[idx] << "' is not as expected ["
+           << parallel_values[idx] + kernel_repetitions << "] after the parallel compression." << endl;
+      return 1;
+    }
+  }
+
+  //TODO: possible cleanup?
+  // if (fileExists(kernel_url)) {
+  //   remove(kernel_url.c_str());
+  // }
+  // if (fileExists(filename)) {
+  //   remove(filename.c_str());
+  // }
+  // if (fileExists(out_filename)) {
+  //   remove(out_filename.c_str());
+  // }
+
+  return 0;
+}
@@ -21,9 +21,7 @@ int runtest(void)
 
   string filename{"copy_" STRINGIZE(COPYTYPE_CL) "_test.h5"};
 
-  if (fileExists(filename)) {
-    remove(filename.c_str());
-  }
+  h5_file config_file(filename, h5_file::truncate);
 
   // kernel
   string kernel_url("copy_kernel.cl");
@@ -44,19 +42,19 @@ kernel void copy(global COPYTYPE const* in, global COPYTYPE* out)\n\
 " << endl;
   kernel_file.close();
 
-  h5_write_string(filename.c_str(), "Kernel_Settings", "-DCOPYTYPE=" STRINGIZE(COPYTYPE_CL));
-  h5_write_string(filename.c_str(), "Kernel_URL", kernel_url.c_str());
+  h5_write_string(config_file, "Kernel_Settings", "-DCOPYTYPE=" STRINGIZE(COPYTYPE_CL));
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
   vector<string> kernels(1, string("copy"));
-  h5_write_strings(filename.c_str(), "Kernels", kernels);
+  h5_write_strings(config_file, "Kernels", kernels);
 
   // ranges
   cl_int tmp_range[3];
   tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
-  h5_write_buffer<cl_int>(filename.c_str(), "Global_Range", tmp_range, 3);
+  h5_write_buffer<cl_int>(config_file, "Global_Range", tmp_range, 3);
 
   tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
-  h5_write_buffer<cl_int>(filename.c_str(), "Local_Range", tmp_range, 3);
-  h5_write_buffer<cl_int>(filename.c_str(), "Range_Start", tmp_range, 3);
+  h5_write_buffer<cl_int>(config_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_int>(config_file, "Range_Start", tmp_range, 3);
 
   // data
   vector<COPYTYPE> in(LENGTH);
@@ -65,18 +63,19 @@ kernel void copy(global COPYTYPE const* in, global COPYTYPE* out)\n\
     in.at(i) = i;
   }
 
-  h5_create_dir(filename.c_str(), "/Data");
-  h5_write_buffer<COPYTYPE>(filename.c_str(), "Data/in", &in[0], LENGTH);
-  h5_write_buffer<COPYTYPE>(filename.c_str(), "Data/out", &out[0], LENGTH);
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<COPYTYPE>(config_file, "Data/in", &in[0], LENGTH);
+  h5_write_buffer<COPYTYPE>(config_file, "Data/out", &out[0], LENGTH);
 
   // single values
   COPYTYPE single_value(21);
-  h5_write_single<COPYTYPE>(filename.c_str(), "Single_Value", single_value);
+  h5_write_single<COPYTYPE>(config_file, "Single_Value", single_value);
 
-  if (single_value != h5_read_single<COPYTYPE>(filename.c_str(), "Single_Value")) {
+  if (single_value != h5_read_single<COPYTYPE>(config_file, "Single_Value")) {
     cerr << "Error: Result 'Single_Value' is not as expected." << endl;
     return 1;
   }
+  config_file.close();
 
 
   // call toolkitICL
@@ -99,8 +98,9 @@ kernel void copy(global COPYTYPE const* in, global COPYTYPE* out)\n\
     cerr << "Error: File " << out_filename << " not found." << endl;
     return 1;
   }
+  h5_file out_file(out_filename, h5_file::read_only);
 
-  h5_read_buffer<COPYTYPE>(out_filename.c_str(), "Data/in", &in_test[0]);
+  h5_read_buffer<COPYTYPE>(out_file, "Data/in", &in_test[0]);
   if (in_test != in) {
     cerr << "Error: Result 'in' is not as expected." << endl;
     // for (int i = 0; i < LENGTH; ++i) {
@@ -109,7 +109,7 @@ kernel void copy(global COPYTYPE const* in, global COPYTYPE* out)\n\
     return 1;
   }
 
-  h5_read_buffer<COPYTYPE>(out_filename.c_str(), "Data/out", &out_test[0]);
+  h5_read_buffer<COPYTYPE>(out_file, "Data/out", &out_test[0]);
   if (out_test != in) { // copy_kernel copies in to out
     cerr << "Error: Result 'out' is not as expected." << endl;
     // for (int i = 0; i < LENGTH; ++i) {
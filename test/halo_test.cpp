@@ -0,0 +1,136 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "opencl_include.hpp"
+#include "util.hpp"
+#include "hdf5_io.hpp"
+
+
+using namespace std;
+
+
+constexpr int LENGTH = 32;
+constexpr int TILE_SIZE = 8;
+
+
+// configuration of a three-point stencil in four tiles with a halo of one row
+void write_config(string const& filename, cl_ulong repetitions)
+{
+  h5_file config_file(filename, h5_file::truncate);
+
+  // kernel summing each value and its neighbours
+  string kernel_url("halo_kernel.cl");
+  ofstream kernel_file;
+  kernel_file.open(kernel_url);
+  kernel_file << "\n\
+kernel void stencil(global float* values, global float* sums, ulong tile_offset)\n\
+{\n\
+  const size_t gid = get_global_id(0);\n\
+  float sum = values[gid - tile_offset];\n\
+  if (gid > 0) {\n\
+    sum += values[gid - 1 - tile_offset];\n\
+  }\n\
+  if (gid + 1 < LENGTH) {\n\
+    sum += values[gid + 1 - tile_offset];\n\
+  }\n\
+  sums[gid - tile_offset] = sum;\n\
+}\n\
+" << endl;
+  kernel_file.close();
+
+  h5_write_string(config_file, "Kernel_Settings", ("-DLENGTH=" + to_string(LENGTH)).c_str());
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
+  vector<string> kernels(1, string("stencil"));
+  h5_write_strings(config_file, "Kernels", kernels);
+  h5_write_single<cl_ulong>(config_file, "Kernel_Repetitions", repetitions);
+
+  // ranges
+  cl_ulong tmp_range[3];
+  tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_ulong>(config_file, "Global_Range", tmp_range, 3);
+
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_ulong>(config_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_ulong>(config_file, "Range_Start", tmp_range, 3);
+
+  h5_write_single<cl_ulong>(config_file, "Tile_Size", TILE_SIZE);
+  h5_write_single<cl_ulong>(config_file, "Tile_Halo", 1);
+
+  // data
+  vector<float> values(LENGTH);
+  vector<float> sums(LENGTH, 0.0f);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    values[idx] = idx * idx;
+  }
+
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<float>(config_file, "Data/values", &values[0], LENGTH);
+  h5_write_buffer<float>(config_file, "Data/sums", &sums[0], LENGTH);
+  config_file.close();
+}
+
+
+int main(void)
+{
+  string filename{"halo_test.h5"};
+  write_config(filename, 1);
+
+  // call toolkitICL
+  string command("toolkitICL -c ");
+  command.append(filename);
+  int retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+
+  // check result; the rows at the tile borders need the halo of the neighbouring tiles
+  string out_filename("out_");
+  out_filename.append(filename);
+  vector<float> sums_test(LENGTH);
+
+  if (!fileExists(out_filename)) {
+    cerr << "Error: File " << out_filename << " not found." << endl;
+    return 1;
+  }
+  h5_file out_file(out_filename, h5_file::read_only);
+
+  h5_read_buffer<float>(out_file, "Data/sums", &sums_test[0]);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    float expected = idx * idx;
+    if (idx > 0) {
+      expected += (idx - 1) * (idx - 1);
+    }
+    if (idx + 1 < LENGTH) {
+      expected += (idx + 1) * (idx + 1);
+    }
+    if (sums_test[idx] != expected) {
+      cerr << "Error: Result 'sums[" << idx << "] == " << sums_test[idx] << "' is not as expected [" << expected << "]." << endl;
+      return 1;
+    }
+  }
+
+  if (h5_read_single<cl_ulong>(out_file, "Tile_Halo") != 1) {
+    cerr << "Error: Tile_Halo is not as expected [1]." << endl;
+    return 1;
+  }
+  out_file.close();
+
+
+  // several repetitions would read halo rows not updated by the neighbouring tiles
+  string repeated_filename{"halo_repeated_test.h5"};
+  write_config(repeated_filename, 2);
+
+  command = "toolkitICL -c " + repeated_filename;
+  retval = system(command.c_str());
+  if (!retval) {
+    cerr << "Error: Tile_Halo with several repetitions is not rejected." << endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,106 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "opencl_include.hpp"
+#include "util.hpp"
+#include "hdf5_io.hpp"
+
+
+using namespace std;
+
+
+int main(void)
+{
+  constexpr int LENGTH = 32;
+  constexpr int GROUP_SIZE = 8;
+
+  string filename{"local_test.h5"};
+
+  h5_file config_file(filename, h5_file::truncate);
+
+  // kernel reversing the values of each work group using local memory
+  string kernel_url("reverse_kernel.cl");
+  ofstream kernel_file;
+  kernel_file.open(kernel_url);
+  kernel_file << "\n\
+kernel void reverse(global int* values, local int* tile)\n\
+{\n\
+  const int gid = get_global_id(0);\n\
+  const int lid = get_local_id(0);\n\
+  const int size = get_local_size(0);\n\
+  tile[lid] = values[gid];\n\
+  barrier(CLK_LOCAL_MEM_FENCE);\n\
+  values[gid] = tile[size - 1 - lid];\n\
+}\n\
+" << endl;
+  kernel_file.close();
+
+  h5_write_string(config_file, "Kernel_Settings", "");
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
+  vector<string> kernels(1, string("reverse"));
+  h5_write_strings(config_file, "Kernels", kernels);
+
+  // ranges
+  cl_int tmp_range[3];
+  tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_int>(config_file, "Global_Range", tmp_range, 3);
+
+  tmp_range[0] = GROUP_SIZE; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_int>(config_file, "Local_Range", tmp_range, 3);
+
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_int>(config_file, "Range_Start", tmp_range, 3);
+
+  // data
+  vector<cl_int> values(LENGTH);
+  for (cl_int i = 0; i < LENGTH; ++i) {
+    values.at(i) = i;
+  }
+
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<cl_int>(config_file, "Data/values", &values[0], LENGTH);
+
+  // one cl_int of local memory per work item
+  cl_uchar per_work_item = 1;
+  h5_create_dir(config_file, "/Local_Args");
+  h5_write_single<cl_ulong>(config_file, "Local_Args/tile", sizeof(cl_int));
+  h5_write_attribute<cl_uchar>(config_file, "Local_Args/tile", "per_work_item", &per_work_item, 1);
+  config_file.close();
+
+
+  // call toolkitICL
+  string command("toolkitICL -c ");
+  command.append(filename);
+  int retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+
+  // check result
+  string out_filename("out_");
+  out_filename.append(filename);
+  vector<cl_int> values_test(LENGTH);
+
+  if (!fileExists(out_filename)) {
+    cerr << "Error: File " << out_filename << " not found." << endl;
+    return 1;
+  }
+  h5_file out_file(out_filename, h5_file::read_only);
+
+  h5_read_buffer<cl_int>(out_file, "Data/values", &values_test[0]);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    size_t group_start = (idx / GROUP_SIZE) * GROUP_SIZE;
+    cl_int expected = values[group_start + GROUP_SIZE - 1 - (idx - group_start)];
+    if (values_test[idx] != expected) {
+      cerr << "Error: Result 'values[" << idx << "] == " << values_test[idx] << "' is not as expected [" << expected << "]." << endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,177 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "opencl_include.hpp"
+#include "util.hpp"
+#include "hdf5_io.hpp"
+
+
+using namespace std;
+
+
+int main(void)
+{
+  constexpr int LENGTH = 32;
+  constexpr int REPETITIONS = 3;
+
+  string filename{"multi_device_test.h5"};
+
+  h5_file config_file(filename, h5_file::truncate);
+
+  // kernel incrementing the values; the neighbouring values are written by the other device
+  string kernel_url("multi_device_kernel.cl");
+  ofstream kernel_file;
+  kernel_file.open(kernel_url);
+  kernel_file << "\n\
+kernel void add_neighbour(global const float* values_in, global float* values, global float* neighbours)\n\
+{\n\
+  const size_t gid = get_global_id(0);\n\
+  values[gid] += 1.0f;\n\
+  neighbours[gid] = values_in[(gid + 16) % 32];\n\
+}\n\
+" << endl;
+  kernel_file.close();
+
+  h5_write_string(config_file, "Kernel_Settings", "");
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
+  vector<string> kernels(1, string("add_neighbour"));
+  h5_write_strings(config_file, "Kernels", kernels);
+  h5_write_single<cl_ulong>(config_file, "Kernel_Repetitions", REPETITIONS);
+
+  // ranges
+  cl_ulong tmp_range[3];
+  tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_ulong>(config_file, "Global_Range", tmp_range, 3);
+
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_ulong>(config_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_ulong>(config_file, "Range_Start", tmp_range, 3);
+
+  // data
+  vector<float> values(LENGTH);
+  vector<float> neighbours(LENGTH, 0.0f);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    values[idx] = idx;
+  }
+
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<float>(config_file, "Data/values_in", &values[0], LENGTH);
+  h5_write_buffer<float>(config_file, "Data/values", &values[0], LENGTH);
+  h5_write_buffer<float>(config_file, "Data/neighbours", &neighbours[0], LENGTH);
+  h5_write_attribute_string(config_file, "Data/values_in", "access", "read_only");
+  h5_write_attribute_string(config_file, "Data/neighbours", "access", "write_only");
+  config_file.close();
+
+
+  // call toolkitICL on two contexts of the first device
+  string command("toolkitICL -d 0,0 -c ");
+  command.append(filename);
+  int retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+
+  // check result
+  string out_filename("out_");
+  out_filename.append(filename);
+  vector<float> values_test(LENGTH);
+  vector<float> neighbours_test(LENGTH);
+
+  if (!fileExists(out_filename)) {
+    cerr << "Error: File " << out_filename << " not found." << endl;
+    return 1;
+  }
+  h5_file out_file(out_filename, h5_file::read_only);
+
+  h5_read_buffer<float>(out_file, "Data/values", &values_test[0]);
+  h5_read_buffer<float>(out_file, "Data/neighbours", &neighbours_test[0]);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    if (values_test[idx] != idx + REPETITIONS) {
+      cerr << "Error: Result 'values[" << idx << "] == " << values_test[idx] << "' is not as expected [" << idx + REPETITIONS << "]." << endl;
+      return 1;
+    }
+    if (neighbours_test[idx] != (idx + 16) % LENGTH) {
+      cerr << "Error: Result 'neighbours[" << idx << "] == " << neighbours_test[idx] << "' is not as expected [" << (idx + 16) % LENGTH << "]." << endl;
+      return 1;
+    }
+  }
+
+  cl_ulong device_rows[2];
+  h5_read_buffer<cl_ulong>(out_file, "Device_Rows", device_rows);
+  if (device_rows[0] + device_rows[1] != LENGTH) {
+    cerr << "Error: Device_Rows [" << device_rows[0] << ", " << device_rows[1] << "] do not cover all " << LENGTH << " rows." << endl;
+    return 1;
+  }
+
+  // the transfer table has one row per dataset; values_in is read, but not written back
+  hsize_t num_fields = 0, num_records = 0;
+  if (H5TBget_table_info(out_file.id(), "/Timing/Transfers/Datasets", &num_fields, &num_records) < 0 || num_records != 3) {
+    cerr << "Error: /Timing/Transfers/Datasets does not contain three rows." << endl;
+    return 1;
+  }
+  double read_times[3] = {0.0, 0.0, 0.0};
+  size_t field_offset[1] = {0};
+  size_t field_size[1] = {sizeof(double)};
+  H5TBread_fields_name(out_file.id(), "/Timing/Transfers/Datasets", "HDF5_Read", 0, 3, sizeof(double), field_offset, field_size, read_times);
+  if (read_times[0] + read_times[1] + read_times[2] <= 0.0) {
+    cerr << "Error: The HDF5 read times of the multi-device execution are missing." << endl;
+    return 1;
+  }
+  out_file.close();
+
+
+  // a second kernel would read rows written by the first kernel on the other device before
+  // they are exchanged, hence several kernels are rejected
+  string pipeline_filename{"multi_device_pipeline_test.h5"};
+  h5_file pipeline_file(pipeline_filename, h5_file::truncate);
+
+  string pipeline_url("multi_device_pipeline_kernel.cl");
+  kernel_file.open(pipeline_url);
+  kernel_file << "\n\
+kernel void flux(global const float* values, global float* fluxes)\n\
+{\n\
+  const size_t gid = get_global_id(0);\n\
+  fluxes[gid] = values[(gid + 1) % 32] - values[gid];\n\
+}\n\
+\n\
+kernel void update(global float* values, global const float* fluxes)\n\
+{\n\
+  const size_t gid = get_global_id(0);\n\
+  values[gid] += fluxes[(gid + 31) % 32];\n\
+}\n\
+" << endl;
+  kernel_file.close();
+
+  h5_write_string(pipeline_file, "Kernel_Settings", "");
+  h5_write_string(pipeline_file, "Kernel_URL", pipeline_url.c_str());
+  vector<string> pipeline_kernels;
+  pipeline_kernels.push_back("flux");
+  pipeline_kernels.push_back("update");
+  h5_write_strings(pipeline_file, "Kernels", pipeline_kernels);
+
+  tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_ulong>(pipeline_file, "Global_Range", tmp_range, 3);
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_ulong>(pipeline_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_ulong>(pipeline_file, "Range_Start", tmp_range, 3);
+
+  h5_create_dir(pipeline_file, "/Data");
+  h5_write_buffer<float>(pipeline_file, "Data/values", &values[0], LENGTH);
+  h5_write_buffer<float>(pipeline_file, "Data/fluxes", &neighbours[0], LENGTH);
+  h5_write_attribute_string(pipeline_file, "Data/fluxes", "access", "write_only");
+  pipeline_file.close();
+
+  command = "toolkitICL -d 0,0 -c " + pipeline_filename;
+  retval = system(command.c_str());
+  if (!retval) {
+    cerr << "Error: Several kernels are not rejected in multi-device mode." << endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,121 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "opencl_include.hpp"
+#include "util.hpp"
+#include "hdf5_io.hpp"
+
+
+using namespace std;
+
+
+int main(void)
+{
+  constexpr int LENGTH = 32;
+  constexpr int REPETITIONS = 3;
+
+  string filename{"numa_test.h5"};
+
+  h5_file config_file(filename, h5_file::truncate);
+
+  // kernel incrementing the values; the neighbouring values are written by the other device
+  string kernel_url("numa_kernel.cl");
+  ofstream kernel_file;
+  kernel_file.open(kernel_url);
+  kernel_file << "\n\
+kernel void add_neighbour(global const float* values_in, global float* values, global float* neighbours)\n\
+{\n\
+  const size_t gid = get_global_id(0);\n\
+  values[gid] += 1.0f;\n\
+  neighbours[gid] = values_in[(gid + 16) % 32];\n\
+}\n\
+" << endl;
+  kernel_file.close();
+
+  h5_write_string(config_file, "Kernel_Settings", "");
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
+  vector<string> kernels(1, string("add_neighbour"));
+  h5_write_strings(config_file, "Kernels", kernels);
+  h5_write_single<cl_ulong>(config_file, "Kernel_Repetitions", REPETITIONS);
+
+  // ranges
+  cl_ulong tmp_range[3];
+  tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_ulong>(config_file, "Global_Range", tmp_range, 3);
+
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_ulong>(config_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_ulong>(config_file, "Range_Start", tmp_range, 3);
+
+  // data
+  vector<float> values(LENGTH);
+  vector<float> neighbours(LENGTH, 0.0f);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    values[idx] = idx;
+  }
+
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<float>(config_file, "Data/values_in", &values[0], LENGTH);
+  h5_write_buffer<float>(config_file, "Data/values", &values[0], LENGTH);
+  h5_write_buffer<float>(config_file, "Data/neighbours", &neighbours[0], LENGTH);
+  h5_write_attribute_string(config_file, "Data/values_in", "access", "read_only");
+  h5_write_attribute_string(config_file, "Data/neighbours", "access", "write_only");
+  config_file.close();
+
+
+  // call toolkitICL; devices without NUMA partitioning are used as a whole
+  string command("toolkitICL -numa -c ");
+  command.append(filename);
+  int retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+
+  // check result
+  string out_filename("out_");
+  out_filename.append(filename);
+  vector<float> values_test(LENGTH);
+  vector<float> neighbours_test(LENGTH);
+
+  if (!fileExists(out_filename)) {
+    cerr << "Error: File " << out_filename << " not found." << endl;
+    return 1;
+  }
+  h5_file out_file(out_filename, h5_file::read_only);
+
+  h5_read_buffer<float>(out_file, "Data/values", &values_test[0]);
+  h5_read_buffer<float>(out_file, "Data/neighbours", &neighbours_test[0]);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    if (values_test[idx] != idx + REPETITIONS) {
+      cerr << "Error: Result 'values[" << idx << "] == " << values_test[idx] << "' is not as expected [" << idx + REPETITIONS << "]." << endl;
+      return 1;
+    }
+    if (neighbours_test[idx] != (idx + 16) % LENGTH) {
+      cerr << "Error: Result 'neighbours[" << idx << "] == " << neighbours_test[idx] << "' is not as expected [" << (idx + 16) % LENGTH << "]." << endl;
+      return 1;
+    }
+  }
+
+  // the rows are only split if the device has been partitioned into several sub-devices
+  if (h5_check_object(out_file, "Device_Rows")) {
+    cl_uint num_nodes = h5_read_single<cl_uint>(out_file, "NUMA_Nodes");
+    vector<cl_ulong> device_rows(num_nodes);
+    h5_read_buffer<cl_ulong>(out_file, "Device_Rows", device_rows.data());
+
+    cl_ulong total_rows = 0;
+    for (cl_ulong rows : device_rows) {
+      total_rows += rows;
+    }
+    if (total_rows != LENGTH) {
+      cerr << "Error: Device_Rows cover " << total_rows << " instead of " << LENGTH << " rows." << endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -18,9 +18,7 @@ int main(void)
 
   string filename{"output_test.h5"};
 
-  if (fileExists(filename)) {
-    remove(filename.c_str());
-  }
+  h5_file config_file(filename, h5_file::truncate);
 
   // kernel
   string kernel_url("add_one_kernel.cl");
@@ -41,21 +39,21 @@ kernel void add_one(global REAL* values)\n\
 " << endl;
   kernel_file.close();
 
-  h5_write_string(filename.c_str(), "Kernel_Settings", "-DREAL=ulong");
-  h5_write_string(filename.c_str(), "Kernel_URL", kernel_url.c_str());
+  h5_write_string(config_file, "Kernel_Settings", "-DREAL=ulong");
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
   vector<string> kernels(1, string("add_one"));
-  h5_write_strings(filename.c_str(), "Kernels", kernels);
+  h5_write_strings(config_file, "Kernels", kernels);
   cl_ulong kernel_repetitions = 10000;
-  h5_write_single<cl_ulong>(filename.c_str(), "Kernel_Repetitions", kernel_repetitions);
+  h5_write_single<cl_ulong>(config_file, "Kernel_Repetitions", kernel_repetitions);
 
   // ranges
   cl_int tmp_range[3];
   tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
-  h5_write_buffer<cl_int>(filename.c_str(), "Global_Range", tmp_range, 3);
+  h5_write_buffer<cl_int>(config_file, "Global_Range", tmp_range, 3);
 
   tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
-  h5_write_buffer<cl_int>(filename.c_str(), "Local_Range", tmp_range, 3);
-  h5_write_buffer<cl_int>(filename.c_str(), "Range_Start", tmp_range, 3);
+  h5_write_buffer<cl_int>(config_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_int>(config_file, "Range_Start", tmp_range, 3);
 
   // data
   vector<cl_ulong> values(LENGTH);
@@ -63,8 +61,9 @@ kernel void add_one(global REAL* values)\n\
     values.at(i) = i;
   }
 
-  h5_create_dir(filename.c_str(), "/Data");
-  h5_write_buffer<cl_ulong>(filename.c_str(), "Data/values", &values[0], LENGTH);
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<cl_ulong>(config_file, "Data/values", &values[0], LENGTH);
+  config_file.close();
 
 
   // call toolkitICL
@@ -86,57 +85,75 @@ kernel void add_one(global REAL* values)\n\
     cerr << "Error: File " << out_filename << " not found." << endl;
     return 1;
   }
+  h5_file out_file(out_filename, h5_file::read_only);
 
-  double Data_LoadTime = h5_read_single<double>(out_filename.c_str(), "Data_LoadTime");
+  double Data_LoadTime = h5_read_single<double>(out_file, "Data_LoadTime");
   cout << "Data_LoadTime   = " << Data_LoadTime << endl;
 
-  double Data_StoreTime = h5_read_single<double>(out_filename.c_str(), "Data_StoreTime");
+  double Data_StoreTime = h5_read_single<double>(out_file, "Data_StoreTime");
   cout << "Data_StoreTime  = " << Data_StoreTime << endl;
 
-  double Kernel_ExecTime = h5_read_single<double>(out_filename.c_str(), "Kernel_ExecTime");
+  double Kernel_ExecTime = h5_read_single<double>(out_file, "Kernel_ExecTime");
   cout << "Kernel_ExecTime = " << Kernel_ExecTime << endl;
 
-  double Total_ExecTime = h5_read_single<double>(out_filename.c_str(), "Total_ExecTime");
+  double Total_ExecTime = h5_read_single<double>(out_file, "Total_ExecTime");
   cout << "Total_ExecTime  = " << Total_ExecTime << endl;
 
   string Kernel_ExecStart;
-  h5_read_string(out_filename.c_str(), "Kernel_ExecStart", Kernel_ExecStart);
+  h5_read_string(out_file, "Kernel_ExecStart", Kernel_ExecStart);
   cout << "Kernel_ExecStart = " << Kernel_ExecStart << endl;
 
   string Kernel_Settings;
-  h5_read_string(out_filename.c_str(), "Kernel_Settings", Kernel_Settings);
+  h5_read_string(out_file, "Kernel_Settings", Kernel_Settings);
   cout << "Kernel_Settings  = " << Kernel_Settings << endl;
 
-  cl_int Global_Range[3];
-  h5_read_buffer<cl_int>(out_filename.c_str(), "Global_Range", &Global_Range[0]);
+  cl_ulong Global_Range[3];
+  h5_read_buffer<cl_ulong>(out_file, "Global_Range", &Global_Range[0]);
   cout << "Global_Range = (" << Global_Range[0]
                      << ", " << Global_Range[1]
                      << ", " << Global_Range[2] << ")" << endl;
 
-  cl_int Local_Range[3];
-  h5_read_buffer<cl_int>(out_filename.c_str(), "Local_Range", &Local_Range[0]);
+  cl_ulong Local_Range[3];
+  h5_read_buffer<cl_ulong>(out_file, "Local_Range", &Local_Range[0]);
   cout << "Local_Range  = (" << Local_Range[0]
                      << ", " << Local_Range[1]
                      << ", " << Local_Range[2] << ")" << endl;
 
-  cl_int Range_Start[3];
-  h5_read_buffer<cl_int>(out_filename.c_str(), "Range_Start", &Range_Start[0]);
+  cl_ulong Range_Start[3];
+  h5_read_buffer<cl_ulong>(out_file, "Range_Start", &Range_Start[0]);
   cout << "Range_Start  = (" << Range_Start[0]
                      << ", " << Range_Start[1]
                      << ", " << Range_Start[2] << ")" << endl;
 
   string Host_OS;
-  h5_read_string(out_filename.c_str(), "Host_OS", Host_OS);
+  h5_read_string(out_file, "Host_OS", Host_OS);
   cout << "Host_OS = " << Host_OS << endl;
 
   string OpenCL_Device;
-  h5_read_string(out_filename.c_str(), "OpenCL_Device", OpenCL_Device);
+  h5_read_string(out_file, "OpenCL_Device", OpenCL_Device);
   cout << "OpenCL_Device  = " << OpenCL_Device << endl;
 
   string OpenCL_Version;
-  h5_read_string(out_filename.c_str(), "OpenCL_Version", OpenCL_Version);
+  h5_read_string(out_file, "OpenCL_Version", OpenCL_Version);
   cout << "OpenCL_Version = " << OpenCL_Version << endl;
 
+  cl_uchar Zero_Copy = h5_read_single<cl_uchar>(out_file, "Zero_Copy");
+  cout << "Zero_Copy      = " << (cl_uint)Zero_Copy << endl;
+
+  double Host_Compile = h5_read_single<double>(out_file, "/Host_Timing/Compile");
+  cout << "Host_Timing/Compile = " << Host_Compile << endl;
+
+  double Host_Total = h5_read_single<double>(out_file, "/Host_Timing/Total");
+  cout << "Host_Timing/Total   = " << Host_Total << endl;
+  if (!(Host_Compile >= 0.0 && Host_Compile <= Host_Total && Total_ExecTime <= Host_Total)) {
+    cerr << "Error: Inconsistent host timing." << endl;
+    return 1;
+  }
+
+  vector<string> Build_Logs;
+  h5_read_strings(out_file, "/Host_Timing/Build_Logs", Build_Logs);
+  cout << "Build logs: " << Build_Logs.size() << endl;
+
   //TODO: possible cleanup?
   // if (fileExists(kernel_url)) {
   //   remove(kernel_url.c_str());
@@ -0,0 +1,109 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "opencl_include.hpp"
+#include "util.hpp"
+#include "hdf5_io.hpp"
+
+
+using namespace std;
+
+
+int main(void)
+{
+  constexpr int LENGTH = 32;
+  constexpr int BOUNDARY = 4;
+
+  string filename{"ranges_test.h5"};
+
+  h5_file config_file(filename, h5_file::truncate);
+
+  // kernels
+  string kernel_url("boundary_kernel.cl");
+  ofstream kernel_file;
+  kernel_file.open(kernel_url);
+  kernel_file << "\n\
+kernel void add_one(global int* values)\n\
+{\n\
+  const int gid = get_global_id(0);\n\
+  values[gid] += 1;\n\
+}\n\
+\n\
+kernel void boundary(global int* values)\n\
+{\n\
+  const int gid = get_global_id(0);\n\
+  values[gid] = -1;\n\
+}\n\
+" << endl;
+  kernel_file.close();
+
+  h5_write_string(config_file, "Kernel_Settings", "");
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
+  vector<string> kernels;
+  kernels.push_back("add_one");
+  kernels.push_back("boundary");
+  h5_write_strings(config_file, "Kernels", kernels);
+
+  // global ranges
+  cl_int tmp_range[3];
+  tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_int>(config_file, "Global_Range", tmp_range, 3);
+
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_int>(config_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_int>(config_file, "Range_Start", tmp_range, 3);
+
+  // ranges of the boundary kernel; the missing Local_Range falls back to the global one
+  h5_create_dir(config_file, "/Ranges");
+  h5_create_dir(config_file, "/Ranges/boundary");
+  tmp_range[0] = BOUNDARY; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_int>(config_file, "Ranges/boundary/Global_Range", tmp_range, 3);
+  tmp_range[0] = LENGTH - BOUNDARY; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_int>(config_file, "Ranges/boundary/Range_Start", tmp_range, 3);
+
+  // data
+  vector<cl_int> values(LENGTH);
+  for (cl_int i = 0; i < LENGTH; ++i) {
+    values.at(i) = i;
+  }
+
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<cl_int>(config_file, "Data/values", &values[0], LENGTH);
+  config_file.close();
+
+
+  // call toolkitICL
+  string command("toolkitICL -c ");
+  command.append(filename);
+  int retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+
+  // check result
+  string out_filename("out_");
+  out_filename.append(filename);
+  vector<cl_int> values_test(LENGTH);
+
+  if (!fileExists(out_filename)) {
+    cerr << "Error: File " << out_filename << " not found." << endl;
+    return 1;
+  }
+  h5_file out_file(out_filename, h5_file::read_only);
+
+  h5_read_buffer<cl_int>(out_file, "Data/values", &values_test[0]);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    cl_int expected = (idx < LENGTH - BOUNDARY) ? values[idx] + 1 : -1;
+    if (values_test[idx] != expected) {
+      cerr << "Error: Result 'values[" << idx << "] == " << values_test[idx] << "' is not as expected [" << expected << "]." << endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
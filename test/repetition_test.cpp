@@ -18,9 +18,7 @@ int main(void)
 
   string filename{"repetition_test.h5"};
 
-  if (fileExists(filename)) {
-    remove(filename.c_str());
-  }
+  h5_file config_file(filename, h5_file::truncate);
 
   // kernel
   string kernel_url("add_one_kernel.cl");
@@ -41,21 +39,21 @@ kernel void add_one(global REAL* values)\n\
 " << endl;
   kernel_file.close();
 
-  h5_write_string(filename.c_str(), "Kernel_Settings", "-DREAL=ulong");
-  h5_write_string(filename.c_str(), "Kernel_URL", kernel_url.c_str());
+  h5_write_string(config_file, "Kernel_Settings", "-DREAL=ulong");
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
   vector<string> kernels(1, string("add_one"));
-  h5_write_strings(filename.c_str(), "Kernels", kernels);
+  h5_write_strings(config_file, "Kernels", kernels);
   cl_ulong kernel_repetitions = 5;
-  h5_write_single<cl_ulong>(filename.c_str(), "Kernel_Repetitions", kernel_repetitions);
+  h5_write_single<cl_ulong>(config_file, "Kernel_Repetitions", kernel_repetitions);
 
   // ranges
   cl_int tmp_range[3];
   tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
-  h5_write_buffer<cl_int>(filename.c_str(), "Global_Range", tmp_range, 3);
+  h5_write_buffer<cl_int>(config_file, "Global_Range", tmp_range, 3);
 
   tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
-  h5_write_buffer<cl_int>(filename.c_str(), "Local_Range", tmp_range, 3);
-  h5_write_buffer<cl_int>(filename.c_str(), "Range_Start", tmp_range, 3);
+  h5_write_buffer<cl_int>(config_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_int>(config_file, "Range_Start", tmp_range, 3);
 
   // data
   vector<cl_ulong> values(LENGTH);
@@ -63,8 +61,9 @@ kernel void add_one(global REAL* values)\n\
     values.at(i) = i;
   }
 
-  h5_create_dir(filename.c_str(), "/Data");
-  h5_write_buffer<cl_ulong>(filename.c_str(), "Data/values", &values[0], LENGTH);
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<cl_ulong>(config_file, "Data/values", &values[0], LENGTH);
+  config_file.close();
 
 
   // call toolkitICL
@@ -86,8 +85,9 @@ kernel void add_one(global REAL* values)\n\
     cerr << "Error: File " << out_filename << " not found." << endl;
     return 1;
   }
+  h5_file out_file(out_filename, h5_file::read_only);
 
-  h5_read_buffer<cl_ulong>(out_filename.c_str(), "Data/values", &values_test[0]);
+  h5_read_buffer<cl_ulong>(out_file, "Data/values", &values_test[0]);
   for (size_t idx = 0; idx < LENGTH; ++idx) {
     if (values_test[idx] != values[idx] + kernel_repetitions) {
       cerr << "Error: Result 'values[" << idx << "] == " << values_test[idx] << "' is not as expected [" << values[idx] + kernel_repetitions << "]." << endl;
@@ -0,0 +1,140 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+#include "opencl_include.hpp"
+#include "util.hpp"
+#include "hdf5_io.hpp"
+
+
+using namespace std;
+
+
+constexpr int LENGTH = 32;
+
+
+// configuration with a maximal launch range of eight work-items and work-groups of `local_size`
+void write_config(string const& filename, cl_ulong local_size)
+{
+  h5_file config_file(filename, h5_file::truncate);
+
+  // kernel writing the global ids
+  string kernel_url("global_id_kernel.cl");
+  ofstream kernel_file;
+  kernel_file.open(kernel_url);
+  kernel_file << "\n\
+kernel void global_id(global ulong* values)\n\
+{\n\
+  const size_t gid = get_global_id(0);\n\
+  values[gid] = gid;\n\
+}\n\
+" << endl;
+  kernel_file.close();
+
+  h5_write_string(config_file, "Kernel_Settings", "");
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
+  vector<string> kernels(1, string("global_id"));
+  h5_write_strings(config_file, "Kernels", kernels);
+
+  // ranges
+  cl_ulong tmp_range[3];
+  tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_ulong>(config_file, "Global_Range", tmp_range, 3);
+
+  tmp_range[0] = local_size; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_ulong>(config_file, "Local_Range", tmp_range, 3);
+
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_ulong>(config_file, "Range_Start", tmp_range, 3);
+
+  h5_write_single<cl_ulong>(config_file, "Max_Launch_Range", 8);
+
+  // data
+  vector<cl_ulong> values(LENGTH, 0);
+
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<cl_ulong>(config_file, "Data/values", &values[0], LENGTH);
+  config_file.close();
+}
+
+
+// check the global ids written to the output file
+bool check_values(string const& out_filename)
+{
+  if (!fileExists(out_filename)) {
+    cerr << "Error: File " << out_filename << " not found." << endl;
+    return false;
+  }
+  h5_file out_file(out_filename, h5_file::read_only);
+
+  vector<cl_ulong> values_test(LENGTH);
+  h5_read_buffer<cl_ulong>(out_file, "Data/values", &values_test[0]);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    if (values_test[idx] != idx) {
+      cerr << "Error: Result 'values[" << idx << "] == " << values_test[idx] << "' is not as expected [" << idx << "]." << endl;
+      return false;
+    }
+  }
+
+  cl_ulong tmp_range[3];
+  h5_read_buffer<cl_ulong>(out_file, "Global_Range", tmp_range);
+  if (tmp_range[0] != LENGTH) {
+    cerr << "Error: Global_Range[0] == " << tmp_range[0] << " is not as expected [" << LENGTH << "]." << endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+int main(void)
+{
+  // the launch is split into four parts with eight work-items each
+  string filename{"split_test.h5"};
+  write_config(filename, 4);
+
+  // call toolkitICL
+  string command("toolkitICL -c ");
+  command.append(filename);
+  int retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+
+  // check result
+  if (!check_values("out_" + filename)) {
+    return 1;
+  }
+
+
+  // A work-group larger than the maximal launch range cannot be split below its size: the parts
+  // are single work-groups of 16 work-items and a warning is given.
+  string group_filename{"split_group_test.h5"};
+  write_config(group_filename, 16);
+
+  string log_filename("split_group_test.log");
+  command = "toolkitICL -c " + group_filename + " 2> " + log_filename;
+  retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+  ifstream log_file(log_filename);
+  string log_content((istreambuf_iterator<char>(log_file)), istreambuf_iterator<char>());
+  if (log_content.find("Warning: Local_Range[0] == 16") == string::npos) {
+    cerr << "Error: No warning about the work-group exceeding Max_Launch_Range in '" << log_filename << "'." << endl;
+    return 1;
+  }
+
+  if (!check_values("out_" + group_filename)) {
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,109 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "opencl_include.hpp"
+#include "util.hpp"
+#include "hdf5_io.hpp"
+
+
+using namespace std;
+
+
+int main(void)
+{
+  constexpr int LENGTH = 32;
+
+  string filename{"swap_test.h5"};
+
+  h5_file config_file(filename, h5_file::truncate);
+
+  // kernel
+  string kernel_url("step_kernel.cl");
+  ofstream kernel_file;
+  kernel_file.open(kernel_url);
+  kernel_file << "\n\
+kernel void step(global int const* u_old, global int* u_new)\n\
+{\n\
+  const int gid = get_global_id(0);\n\
+  u_new[gid] = u_old[gid] + 1;\n\
+}\n\
+" << endl;
+  kernel_file.close();
+
+  h5_write_string(config_file, "Kernel_Settings", "");
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
+  vector<string> kernels(1, string("step"));
+  h5_write_strings(config_file, "Kernels", kernels);
+  cl_ulong kernel_repetitions = 4;
+  h5_write_single<cl_ulong>(config_file, "Kernel_Repetitions", kernel_repetitions);
+
+  vector<string> swap_args;
+  swap_args.push_back("u_old");
+  swap_args.push_back("u_new");
+  h5_write_strings(config_file, "Swap_Args", swap_args);
+
+  // ranges
+  cl_int tmp_range[3];
+  tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_int>(config_file, "Global_Range", tmp_range, 3);
+
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_int>(config_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_int>(config_file, "Range_Start", tmp_range, 3);
+
+  // data
+  vector<cl_int> values(LENGTH, 0);
+
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<cl_int>(config_file, "Data/u_new", &values[0], LENGTH);
+  h5_write_buffer<cl_int>(config_file, "Data/u_old", &values[0], LENGTH);
+  config_file.close();
+
+
+  // call toolkitICL
+  string command("toolkitICL -c ");
+  command.append(filename);
+  int retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+
+  // check result; after three swaps, the last step has been written to the buffer of `u_old`
+  string out_filename("out_");
+  out_filename.append(filename);
+  vector<cl_int> values_test(LENGTH);
+
+  if (!fileExists(out_filename)) {
+    cerr << "Error: File " << out_filename << " not found." << endl;
+    return 1;
+  }
+  h5_file out_file(out_filename, h5_file::read_only);
+
+  cl_ulong swap_count = h5_read_single<cl_ulong>(out_file, "Swap_Count");
+  if (swap_count != kernel_repetitions - 1) {
+    cerr << "Error: Swap_Count " << swap_count << " is not as expected [" << kernel_repetitions - 1 << "]." << endl;
+    return 1;
+  }
+
+  string bound_to;
+  h5_read_attribute_string(out_file, "Data/u_old", "bound_to", bound_to);
+  if (bound_to != "/Data/u_new") {
+    cerr << "Error: 'u_old' is bound to '" << bound_to << "' instead of '/Data/u_new'." << endl;
+    return 1;
+  }
+
+  h5_read_buffer<cl_int>(out_file, "Data/u_old", &values_test[0]);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    if (values_test[idx] != (cl_int)kernel_repetitions) {
+      cerr << "Error: Result 'u_old[" << idx << "] == " << values_test[idx] << "' is not as expected [" << kernel_repetitions << "]." << endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
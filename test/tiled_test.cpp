@@ -0,0 +1,131 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "opencl_include.hpp"
+#include "util.hpp"
+#include "hdf5_io.hpp"
+
+
+using namespace std;
+
+
+int main(void)
+{
+  constexpr int LENGTH = 32;
+  constexpr int TILE_SIZE = 8;
+
+  string filename{"tiled_test.h5"};
+
+  h5_file config_file(filename, h5_file::truncate);
+
+  // kernels incrementing the values and writing the global row index
+  string kernel_url("tiled_kernel.cl");
+  ofstream kernel_file;
+  kernel_file.open(kernel_url);
+  kernel_file << "\n\
+kernel void add_one(global float* values)\n\
+{\n\
+  const size_t gid = get_global_id(0);\n\
+  values[gid] += 1.0f;\n\
+}\n\
+\n\
+kernel void row_index(global ulong* rows, ulong tile_offset)\n\
+{\n\
+  const size_t gid = get_global_id(0);\n\
+  rows[gid - tile_offset] = gid;\n\
+}\n\
+" << endl;
+  kernel_file.close();
+
+  h5_write_string(config_file, "Kernel_Settings", "");
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
+  vector<string> kernels;
+  kernels.push_back("add_one");
+  kernels.push_back("row_index");
+  h5_write_strings(config_file, "Kernels", kernels);
+
+  // ranges
+  cl_ulong tmp_range[3];
+  tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_ulong>(config_file, "Global_Range", tmp_range, 3);
+
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_ulong>(config_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_ulong>(config_file, "Range_Start", tmp_range, 3);
+
+  // four tiles
+  h5_write_single<cl_ulong>(config_file, "Tile_Size", TILE_SIZE);
+
+  // data
+  vector<float> values(LENGTH);
+  vector<cl_ulong> rows(LENGTH, 0);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    values[idx] = idx;
+  }
+
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<float>(config_file, "Data/values", &values[0], LENGTH);
+  h5_write_buffer<cl_ulong>(config_file, "Data/rows", &rows[0], LENGTH);
+  config_file.close();
+
+
+  // call toolkitICL
+  string command("toolkitICL -c ");
+  command.append(filename);
+  int retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+
+  // check result
+  string out_filename("out_");
+  out_filename.append(filename);
+  vector<float> values_test(LENGTH);
+  vector<cl_ulong> rows_test(LENGTH);
+
+  if (!fileExists(out_filename)) {
+    cerr << "Error: File " << out_filename << " not found." << endl;
+    return 1;
+  }
+  h5_file out_file(out_filename, h5_file::read_only);
+
+  h5_read_buffer<float>(out_file, "Data/values", &values_test[0]);
+  h5_read_buffer<cl_ulong>(out_file, "Data/rows", &rows_test[0]);
+  for (size_t idx = 0; idx < LENGTH; ++idx) {
+    if (values_test[idx] != idx + 1.0f) {
+      cerr << "Error: Result 'values[" << idx << "] == " << values_test[idx] << "' is not as expected [" << idx + 1.0f << "]." << endl;
+      return 1;
+    }
+    if (rows_test[idx] != idx) {
+      cerr << "Error: Result 'rows[" << idx << "] == " << rows_test[idx] << "' is not as expected [" << idx << "]." << endl;
+      return 1;
+    }
+  }
+
+  if (h5_read_single<cl_ulong>(out_file, "Tile_Size") != TILE_SIZE) {
+    cerr << "Error: Tile_Size is not as expected [" << TILE_SIZE << "]." << endl;
+    return 1;
+  }
+
+  // the transfer table has one row per dataset, written in parts by the tiles
+  hsize_t num_fields = 0, num_records = 0;
+  if (H5TBget_table_info(out_file.id(), "/Timing/Transfers/Datasets", &num_fields, &num_records) < 0 || num_records != 2) {
+    cerr << "Error: /Timing/Transfers/Datasets does not contain two rows." << endl;
+    return 1;
+  }
+  double write_times[2] = {0.0, 0.0};
+  size_t field_offset[1] = {0};
+  size_t field_size[1] = {sizeof(double)};
+  H5TBread_fields_name(out_file.id(), "/Timing/Transfers/Datasets", "HDF5_Write", 0, 2, sizeof(double), field_offset, field_size, write_times);
+  if (write_times[0] <= 0.0 || write_times[1] <= 0.0) {
+    cerr << "Error: The HDF5 write times [" << write_times[0] << ", " << write_times[1] << "] of the tiles are missing." << endl;
+    return 1;
+  }
+
+  return 0;
+}
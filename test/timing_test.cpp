@@ -0,0 +1,186 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "opencl_include.hpp"
+#include "util.hpp"
+#include "hdf5_io.hpp"
+
+
+using namespace std;
+
+
+// the launches are executed one after another, hence their durations sum up to at most the
+// wall time of the kernel loop
+bool check_duration_sum(h5_file const& out_file, string const* kernel_names, size_t const* num_launches)
+{
+  double sum = 0.0;
+  for (int k = 0; k < 2; ++k) {
+    vector<double> durations(num_launches[k]);
+    h5_read_buffer<double>(out_file, ("/Timing/" + kernel_names[k] + "/Durations").c_str(), &durations[0]);
+    for (double duration : durations) {
+      sum += duration;
+    }
+  }
+
+  double total = h5_read_single<double>(out_file, "Total_ExecTime");
+  if (sum > total) {
+    cerr << "Error: The launch durations sum up to " << sum << " ms, exceeding the kernel loop of " << total << " ms." << endl;
+    return false;
+  }
+  return true;
+}
+
+
+int main(void)
+{
+  constexpr int LENGTH = 64;
+  constexpr int REPETITIONS = 10;
+
+  string filename{"timing_test.h5"};
+
+  h5_file config_file(filename, h5_file::truncate);
+
+  // `add_one` is scheduled twice per repetition
+  string kernel_url("timing_kernel.cl");
+  ofstream kernel_file;
+  kernel_file.open(kernel_url);
+  kernel_file << "\n\
+kernel void add_one(global float* values)\n\
+{\n\
+  const size_t gid = get_global_id(0);\n\
+  values[gid] += 1.0f;\n\
+}\n\
+\n\
+kernel void twice(global float* values)\n\
+{\n\
+  const size_t gid = get_global_id(0);\n\
+  values[gid] *= 2.0f;\n\
+}\n\
+" << endl;
+  kernel_file.close();
+
+  h5_write_string(config_file, "Kernel_Settings", "");
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
+  vector<string> kernels;
+  kernels.push_back("add_one");
+  kernels.push_back("twice");
+  kernels.push_back("add_one");
+  h5_write_strings(config_file, "Kernels", kernels);
+  h5_write_single<cl_ulong>(config_file, "Kernel_Repetitions", REPETITIONS);
+
+  // ranges
+  cl_ulong tmp_range[3];
+  tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_ulong>(config_file, "Global_Range", tmp_range, 3);
+
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_ulong>(config_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_ulong>(config_file, "Range_Start", tmp_range, 3);
+
+  // data
+  vector<float> values(LENGTH, 0.0f);
+
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<float>(config_file, "Data/values", &values[0], LENGTH);
+  config_file.close();
+
+
+  // call toolkitICL
+  string command("toolkitICL -c ");
+  command.append(filename);
+  int retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+
+  // check result
+  string out_filename("out_");
+  out_filename.append(filename);
+
+  if (!fileExists(out_filename)) {
+    cerr << "Error: File " << out_filename << " not found." << endl;
+    return 1;
+  }
+  h5_file out_file(out_filename, h5_file::read_only);
+
+  string kernel_names[2] = {"add_one", "twice"};
+  size_t num_launches[2] = {2 * REPETITIONS, REPETITIONS};
+  for (int k = 0; k < 2; ++k) {
+    string group = "/Timing/" + kernel_names[k] + "/";
+    vector<hsize_t> dims;
+    h5_get_dims(out_file, (group + "Durations").c_str(), dims);
+    if (dims.empty() || dims[0] != num_launches[k]) {
+      cerr << "Error: " << group << "Durations does not contain " << num_launches[k] << " launches." << endl;
+      return 1;
+    }
+
+    double min = h5_read_single<double>(out_file, (group + "Min").c_str());
+    double median = h5_read_single<double>(out_file, (group + "Median").c_str());
+    double mean = h5_read_single<double>(out_file, (group + "Mean").c_str());
+    double p95 = h5_read_single<double>(out_file, (group + "P95").c_str());
+    double p99 = h5_read_single<double>(out_file, (group + "P99").c_str());
+    double max = h5_read_single<double>(out_file, (group + "Max").c_str());
+    if (!(min <= median && median <= p95 && p95 <= p99 && p99 <= max && min <= mean && mean <= max)) {
+      cerr << "Error: Inconsistent statistics in " << group << ": min " << min << ", median " << median << ", mean " << mean
+           << ", p95 " << p95 << ", p99 " << p99 << ", max " << max << endl;
+      return 1;
+    }
+
+    // the profiling phases of every launch are ordered
+    vector<cl_ulong> queued(num_launches[k]), submit(num_launches[k]), start(num_launches[k]), end(num_launches[k]);
+    h5_read_buffer<cl_ulong>(out_file, (group + "Queued").c_str(), &queued[0]);
+    h5_read_buffer<cl_ulong>(out_file, (group + "Submit").c_str(), &submit[0]);
+    h5_read_buffer<cl_ulong>(out_file, (group + "Start").c_str(), &start[0]);
+    h5_read_buffer<cl_ulong>(out_file, (group + "End").c_str(), &end[0]);
+    for (size_t idx = 0; idx < num_launches[k]; ++idx) {
+      if (!(queued[idx] <= submit[idx] && submit[idx] <= start[idx] && start[idx] <= end[idx])) {
+        cerr << "Error: Unordered profiling timestamps of launch " << idx << " in " << group << endl;
+        return 1;
+      }
+    }
+    if (!h5_check_object(out_file, (group + "Queue_Latency").c_str()) || !h5_check_object(out_file, (group + "Device_Time").c_str())) {
+      cerr << "Error: Phase durations missing in " << group << endl;
+      return 1;
+    }
+  }
+
+  // the transfer table has one row per dataset
+  hsize_t num_fields = 0, num_records = 0;
+  if (H5TBget_table_info(out_file.id(), "/Timing/Transfers/Datasets", &num_fields, &num_records) < 0 || num_records != 1) {
+    cerr << "Error: /Timing/Transfers/Datasets does not contain one row." << endl;
+    return 1;
+  }
+  cl_ulong bytes = 0;
+  size_t field_offset[1] = {0};
+  size_t field_size[1] = {sizeof(cl_ulong)};
+  H5TBread_fields_name(out_file.id(), "/Timing/Transfers/Datasets", "Bytes", 0, 1, sizeof(cl_ulong), field_offset, field_size, &bytes);
+  if (bytes != LENGTH * sizeof(float)) {
+    cerr << "Error: " << bytes << " bytes instead of " << LENGTH * sizeof(float) << " in the transfer table." << endl;
+    return 1;
+  }
+
+  if (!check_duration_sum(out_file, kernel_names, num_launches)) {
+    return 1;
+  }
+  out_file.close();
+
+  // in asynchronous mode, all launches are submitted at once
+  command = string("toolkitICL -a -c ");
+  command.append(filename);
+  retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+  h5_file async_out_file(out_filename, h5_file::read_only);
+  if (!check_duration_sum(async_out_file, kernel_names, num_launches)) {
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,107 @@
+/* This project is licensed under the terms of the Creative Commons CC BY-NC-ND 4.0 license. */
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "opencl_include.hpp"
+#include "util.hpp"
+#include "hdf5_io.hpp"
+
+
+using namespace std;
+
+
+int main(void)
+{
+  constexpr int LENGTH = 64;
+
+  string filename{"trace_test.h5"};
+  string trace_filename{"trace_test.json"};
+
+  h5_file config_file(filename, h5_file::truncate);
+
+  string kernel_url("trace_kernel.cl");
+  ofstream kernel_file;
+  kernel_file.open(kernel_url);
+  kernel_file << "\n\
+kernel void add_one(global float* values)\n\
+{\n\
+  const size_t gid = get_global_id(0);\n\
+  values[gid] += 1.0f;\n\
+}\n\
+" << endl;
+  kernel_file.close();
+
+  h5_write_string(config_file, "Kernel_Settings", "");
+  h5_write_string(config_file, "Kernel_URL", kernel_url.c_str());
+  vector<string> kernels;
+  kernels.push_back("add_one");
+  h5_write_strings(config_file, "Kernels", kernels);
+  h5_write_single<cl_ulong>(config_file, "Kernel_Repetitions", 3);
+
+  // ranges
+  cl_ulong tmp_range[3];
+  tmp_range[0] = LENGTH; tmp_range[1] = 1; tmp_range[2] = 1;
+  h5_write_buffer<cl_ulong>(config_file, "Global_Range", tmp_range, 3);
+
+  tmp_range[0] = 0; tmp_range[1] = 0; tmp_range[2] = 0;
+  h5_write_buffer<cl_ulong>(config_file, "Local_Range", tmp_range, 3);
+  h5_write_buffer<cl_ulong>(config_file, "Range_Start", tmp_range, 3);
+
+  // data
+  vector<float> values(LENGTH, 0.0f);
+
+  h5_create_dir(config_file, "/Data");
+  h5_write_buffer<float>(config_file, "Data/values", &values[0], LENGTH);
+  config_file.close();
+
+
+  // call toolkitICL
+  string command("toolkitICL -c ");
+  command.append(filename);
+  command.append(" -trace ");
+  command.append(trace_filename);
+  int retval = system(command.c_str());
+  if (retval) {
+    cerr << "Error: " << retval << endl;
+    return 1;
+  }
+
+
+  // check the trace
+  if (!fileExists(trace_filename)) {
+    cerr << "Error: File " << trace_filename << " not found." << endl;
+    return 1;
+  }
+  ifstream trace_file(trace_filename);
+  stringstream trace;
+  trace << trace_file.rdbuf();
+  string content = trace.str();
+
+  if (content.find("\"traceEvents\"") == string::npos || content.find("]}") == string::npos) {
+    cerr << "Error: " << trace_filename << " is not a trace event file." << endl;
+    return 1;
+  }
+
+  string stages[5] = {"Device init", "Compile", "HDF5 read /Data/values", "Kernel loop", "HDF5 write /Data/values"};
+  for (string const& stage : stages) {
+    if (content.find("\"" + stage + "\"") == string::npos) {
+      cerr << "Error: Host stage '" << stage << "' missing in " << trace_filename << endl;
+      return 1;
+    }
+  }
+
+  // every launch is a device command
+  size_t launches = 0;
+  for (size_t pos = content.find("\"name\": \"add_one\""); pos != string::npos; pos = content.find("\"name\": \"add_one\"", pos + 1)) {
+    ++launches;
+  }
+  if (launches != 3) {
+    cerr << "Error: " << launches << " instead of 3 launches in " << trace_filename << endl;
+    return 1;
+  }
+
+  return 0;
+}